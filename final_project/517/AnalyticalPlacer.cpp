@@ -0,0 +1,358 @@
+#include "AnalyticalPlacer.h"
+#include <iostream>
+#include <numeric>
+#include <chrono>
+
+using namespace std;
+
+// ----------------------------------------------------------------------
+// 調整參數
+// ----------------------------------------------------------------------
+static const int    CG_MAX_ITER      = 200;   // 二次線長 CG 最大迭代數
+static const double CG_TOL           = 1e-6;  // CG 相對殘差
+static const double ANCHOR_EPS       = 1e-3;  // 拉向 chip 中心的微弱錨點 (保持正定)
+static const int    OUTER_ITER       = 40;    // lambda 調整次數
+static const int    INNER_ITER       = 60;    // 每個 lambda 的 Nesterov 迭代數
+static const double LAMBDA_GROWTH    = 1.6;   // lambda 每輪放大倍率
+static const double TARGET_OVERLAP   = 0.02;  // 重疊面積 / soft 總面積 低於此值即停止
+static const double GAMMA_RATIO      = 0.005; // gamma = 比例 * (chip_w + chip_h)
+
+// ----------------------------------------------------------------------
+// 放置主函數
+// ----------------------------------------------------------------------
+void AnalyticalPlacer::place() {
+    cout << "--- Starting Global Placement (Analytical, Nesterov) ---" << endl;
+    auto t0 = chrono::steady_clock::now();
+
+    n = data.soft_modules.size();
+    if (n == 0) {
+        cout << "--- Global Placement Finished ---" << endl;
+        return;
+    }
+
+    buildCSR();
+    gamma = max(1.0, GAMMA_RATIO * (data.chip_w + data.chip_h));
+
+    // 1. 二次線長初始解
+    vector<double> x(n), y(n);
+    solveQuadratic(x, true);
+    solveQuadratic(y, false);
+    clampToChip(x, y);
+
+    double total_area = 0;
+    for (const auto& m : data.soft_modules) total_area += (double)m.s_len * m.s_len;
+
+    // 2. lambda 初始值: 讓兩項梯度大小相當 (ePlace 作法)
+    vector<double> gwx(n), gwy(n), gox(n), goy(n);
+    wirelength(x, y, gwx, gwy);
+    double ov = overlap(x, y, gox, goy);
+    double gw_norm = 0, go_norm = 0;
+    for (int i = 0; i < n; ++i) {
+        gw_norm += fabs(gwx[i]) + fabs(gwy[i]);
+        go_norm += fabs(gox[i]) + fabs(goy[i]);
+    }
+    double lambda = (go_norm > 0) ? gw_norm / go_norm : 1.0;
+
+    // 3. Nesterov 加速梯度法 (Barzilai-Borwein 步長 + 投影到 chip 範圍)
+    vector<double> u_x = x, u_y = y;   // 主序列
+    vector<double> v_x = x, v_y = y;   // 前瞻點
+    vector<double> g_x(n), g_y(n), pv_x(n), pv_y(n), pg_x(n), pg_y(n);
+
+    auto gradient = [&](const vector<double>& px, const vector<double>& py) {
+        wirelength(px, py, gwx, gwy);
+        overlap(px, py, gox, goy);
+        for (int i = 0; i < n; ++i) {
+            g_x[i] = gwx[i] + lambda * gox[i];
+            g_y[i] = gwy[i] + lambda * goy[i];
+        }
+    };
+
+    int outer = 0;
+    for (; outer < OUTER_ITER; ++outer) {
+        double a = 1.0;
+        double step = 0;
+        bool have_prev = false;
+
+        for (int it = 0; it < INNER_ITER; ++it) {
+            gradient(v_x, v_y);
+
+            // BB 步長 (第一步: 最大位移約為 chip 尺寸的 1%)
+            if (!have_prev) {
+                double g_max = 1e-12;
+                for (int i = 0; i < n; ++i) g_max = max(g_max, max(fabs(g_x[i]), fabs(g_y[i])));
+                step = 0.01 * (data.chip_w + data.chip_h) / g_max;
+            } else {
+                double sy = 0, ss = 0;
+                for (int i = 0; i < n; ++i) {
+                    double sx_i = v_x[i] - pv_x[i], sy_i = v_y[i] - pv_y[i];
+                    sy += sx_i * (g_x[i] - pg_x[i]) + sy_i * (g_y[i] - pg_y[i]);
+                    ss += sx_i * sx_i + sy_i * sy_i;
+                }
+                if (sy > 0 && ss > 0) step = ss / sy;
+            }
+            pv_x = v_x; pv_y = v_y; pg_x = g_x; pg_y = g_y;
+            have_prev = true;
+
+            vector<double> nu_x(n), nu_y(n);
+            for (int i = 0; i < n; ++i) {
+                nu_x[i] = v_x[i] - step * g_x[i];
+                nu_y[i] = v_y[i] - step * g_y[i];
+            }
+            clampToChip(nu_x, nu_y);
+
+            double a_next = (1.0 + sqrt(4.0 * a * a + 1.0)) / 2.0;
+            double coef = (a - 1.0) / a_next;
+            for (int i = 0; i < n; ++i) {
+                v_x[i] = nu_x[i] + coef * (nu_x[i] - u_x[i]);
+                v_y[i] = nu_y[i] + coef * (nu_y[i] - u_y[i]);
+            }
+            clampToChip(v_x, v_y);
+            u_x.swap(nu_x); u_y.swap(nu_y);
+            a = a_next;
+        }
+
+        ov = overlap(u_x, u_y, gox, goy);
+        if (ov / total_area < TARGET_OVERLAP) break;
+
+        lambda *= LAMBDA_GROWTH;
+        v_x = u_x; v_y = u_y;
+    }
+
+    vector<double> dummy_x(n), dummy_y(n);
+    double wl = wirelength(u_x, u_y, dummy_x, dummy_y);
+    storeResults(u_x, u_y);
+
+    auto t1 = chrono::steady_clock::now();
+    cout << "  - Rounds: " << min(outer + 1, OUTER_ITER) << ", smoothed HPWL: " << wl
+         << ", overlap ratio: " << ov / total_area << endl;
+    cout << "  - Runtime: " << chrono::duration<double, milli>(t1 - t0).count() << " ms" << endl;
+    cout << "--- Global Placement Finished ---" << endl;
+}
+
+// ----------------------------------------------------------------------
+// 建立 CSR 連線陣列 (只走實際存在的連線)
+// ----------------------------------------------------------------------
+void AnalyticalPlacer::buildCSR() {
+    half_w.resize(n);
+    for (int i = 0; i < n; ++i) half_w[i] = data.soft_modules[i].s_len / 2.0;
+    for (const auto& f : data.fixed_modules) {
+        fixed_cx.push_back(f.fixed_x + f.fixed_w / 2.0);
+        fixed_cy.push_back(f.fixed_y + f.fixed_h / 2.0);
+        fixed_hw.push_back(f.fixed_w / 2.0);
+        fixed_hh.push_back(f.fixed_h / 2.0);
+    }
+
+    // 先計數再填入 (兩趟)
+    vector<int> deg(n, 0), adeg(n, 0);
+    struct Edge { int a, b; bool b_fixed; double w; };
+    vector<Edge> edges;
+    // 使用 readInput 建立的 ID 連線 (soft = 0..n-1, fixed = n..)
+    edges.reserve(data.edge_a.size());
+    for (size_t e = 0; e < data.edge_a.size(); ++e) {
+        if (data.edge_w[e] <= 0) continue;
+        int a = data.edge_a[e], b = data.edge_b[e];
+        bool a_soft = data.isSoftId(a), b_soft = data.isSoftId(b);
+        if (a_soft && b_soft) {
+            edges.push_back({a, b, false, (double)data.edge_w[e]});
+            deg[a]++;
+            deg[b]++;
+        } else if (a_soft || b_soft) {
+            // Soft-Fixed
+            int s = a_soft ? a : b;
+            int f = (a_soft ? b : a) - n;
+            edges.push_back({s, f, true, (double)data.edge_w[e]});
+            adeg[s]++;
+        }
+        // Fixed-Fixed: 常數，忽略
+    }
+
+    row_ptr.assign(n + 1, 0);
+    anchor_ptr.assign(n + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        row_ptr[i + 1] = row_ptr[i] + deg[i];
+        anchor_ptr[i + 1] = anchor_ptr[i] + adeg[i];
+    }
+    col_idx.resize(row_ptr[n]);
+    edge_w.resize(row_ptr[n]);
+    anchor_x.resize(anchor_ptr[n]);
+    anchor_y.resize(anchor_ptr[n]);
+    anchor_w.resize(anchor_ptr[n]);
+
+    vector<int> efill(row_ptr.begin(), row_ptr.end() - 1), afill(anchor_ptr.begin(), anchor_ptr.end() - 1);
+    for (const auto& e : edges) {
+        if (!e.b_fixed) {
+            col_idx[efill[e.a]] = e.b; edge_w[efill[e.a]++] = e.w;
+            col_idx[efill[e.b]] = e.a; edge_w[efill[e.b]++] = e.w;
+        } else {
+            anchor_x[afill[e.a]] = fixed_cx[e.b];
+            anchor_y[afill[e.a]] = fixed_cy[e.b];
+            anchor_w[afill[e.a]++] = e.w;
+        }
+    }
+
+    cout << "  - CSR built: " << row_ptr[n] / 2 << " soft-soft, " << anchor_ptr[n] << " soft-fixed edges" << endl;
+}
+
+// ----------------------------------------------------------------------
+// 二次線長: Minimize Sum w_ij (p_i - p_j)^2 + Sum w_if (p_i - f)^2 + eps (p_i - c)^2
+// 即解 (L + D) p = b，L 為 Laplacian，以 CG 求解 (矩陣只以 CSR 乘法出現)
+// ----------------------------------------------------------------------
+void AnalyticalPlacer::solveQuadratic(vector<double>& pos, bool is_x) {
+    const double center = (is_x ? data.chip_w : data.chip_h) / 2.0;
+
+    vector<double> diag(n, 0.0), b(n, 0.0);
+    for (int i = 0; i < n; ++i) {
+        for (int k = row_ptr[i]; k < row_ptr[i + 1]; ++k) diag[i] += edge_w[k];
+        for (int k = anchor_ptr[i]; k < anchor_ptr[i + 1]; ++k) {
+            diag[i] += anchor_w[k];
+            b[i] += anchor_w[k] * (is_x ? anchor_x[k] : anchor_y[k]);
+        }
+        diag[i] += ANCHOR_EPS;
+        b[i] += ANCHOR_EPS * center;
+    }
+
+    auto matvec = [&](const vector<double>& v, vector<double>& out) {
+        for (int i = 0; i < n; ++i) {
+            double s = diag[i] * v[i];
+            for (int k = row_ptr[i]; k < row_ptr[i + 1]; ++k) s -= edge_w[k] * v[col_idx[k]];
+            out[i] = s;
+        }
+    };
+
+    // Jacobi 前置條件 CG
+    pos.assign(n, center);
+    vector<double> r(n), z(n), p(n), Ap(n);
+    matvec(pos, Ap);
+    for (int i = 0; i < n; ++i) r[i] = b[i] - Ap[i];
+    for (int i = 0; i < n; ++i) z[i] = r[i] / diag[i];
+    p = z;
+    double rz = inner_product(r.begin(), r.end(), z.begin(), 0.0);
+    const double b_norm = sqrt(inner_product(b.begin(), b.end(), b.begin(), 0.0));
+
+    for (int it = 0; it < CG_MAX_ITER; ++it) {
+        double r_norm = sqrt(inner_product(r.begin(), r.end(), r.begin(), 0.0));
+        if (r_norm <= CG_TOL * max(1.0, b_norm)) break;
+        matvec(p, Ap);
+        double pAp = inner_product(p.begin(), p.end(), Ap.begin(), 0.0);
+        if (pAp <= 0) break;
+        double alpha = rz / pAp;
+        for (int i = 0; i < n; ++i) {
+            pos[i] += alpha * p[i];
+            r[i] -= alpha * Ap[i];
+            z[i] = r[i] / diag[i];
+        }
+        double rz_new = inner_product(r.begin(), r.end(), z.begin(), 0.0);
+        double beta = rz_new / rz;
+        rz = rz_new;
+        for (int i = 0; i < n; ++i) p[i] = z[i] + beta * p[i];
+    }
+}
+
+// ----------------------------------------------------------------------
+// LSE 平滑線長: 兩端點網路 max - min 的 LSE 近似為
+//   |d| + 2 gamma log(1 + exp(-|d| / gamma))，對 d 的導數為 tanh(d / (2 gamma))
+// ----------------------------------------------------------------------
+double AnalyticalPlacer::wirelength(const vector<double>& x, const vector<double>& y,
+                                    vector<double>& gx, vector<double>& gy) const {
+    auto lse = [&](double d, double& grad) -> double {
+        grad = tanh(d / (2.0 * gamma));
+        double ad = fabs(d);
+        return ad + 2.0 * gamma * log1p(exp(-ad / gamma));
+    };
+
+    double wl = 0;
+    fill(gx.begin(), gx.end(), 0.0);
+    fill(gy.begin(), gy.end(), 0.0);
+    for (int i = 0; i < n; ++i) {
+        // Soft-Soft (每條邊只算一次: j > i)
+        for (int k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+            int j = col_idx[k];
+            if (j <= i) continue;
+            double w = edge_w[k], g;
+            wl += w * lse(x[i] - x[j], g);
+            gx[i] += w * g; gx[j] -= w * g;
+            wl += w * lse(y[i] - y[j], g);
+            gy[i] += w * g; gy[j] -= w * g;
+        }
+        // Soft-Fixed
+        for (int k = anchor_ptr[i]; k < anchor_ptr[i + 1]; ++k) {
+            double w = anchor_w[k], g;
+            wl += w * lse(x[i] - anchor_x[k], g);
+            gx[i] += w * g;
+            wl += w * lse(y[i] - anchor_y[k], g);
+            gy[i] += w * g;
+        }
+    }
+    return wl;
+}
+
+// ----------------------------------------------------------------------
+// 重疊懲罰: 各對模組重疊面積 ox * oy 之和
+//   ox = max(0, (hw_i + hw_j) - |x_i - x_j|)，oy 同理
+// Soft-Soft 以 x 排序後掃描剪枝，Soft-Fixed 逐一檢查 (fixed 數量少)
+// ----------------------------------------------------------------------
+double AnalyticalPlacer::overlap(const vector<double>& x, const vector<double>& y,
+                                 vector<double>& gx, vector<double>& gy) const {
+    fill(gx.begin(), gx.end(), 0.0);
+    fill(gy.begin(), gy.end(), 0.0);
+
+    double max_hw = 0;
+    for (int i = 0; i < n; ++i) max_hw = max(max_hw, half_w[i]);
+
+    vector<int> order(n);
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](int a, int b) { return x[a] < x[b]; });
+
+    auto pair_term = [&](double dx, double dy, double sx, double sy, double& g_x, double& g_y) -> double {
+        double ox = sx - fabs(dx), oy = sy - fabs(dy);
+        if (ox <= 0 || oy <= 0) { g_x = g_y = 0; return 0; }
+        // d(ox*oy)/d(dx) = -sign(dx) * oy
+        g_x = -(dx >= 0 ? 1.0 : -1.0) * oy;
+        g_y = -(dy >= 0 ? 1.0 : -1.0) * ox;
+        return ox * oy;
+    };
+
+    double total = 0;
+    for (int a = 0; a < n; ++a) {
+        int i = order[a];
+        for (int b = a + 1; b < n; ++b) {
+            int j = order[b];
+            if (x[j] - x[i] >= half_w[i] + max_hw) break;
+            double s = half_w[i] + half_w[j], g_x, g_y;
+            double o = pair_term(x[i] - x[j], y[i] - y[j], s, s, g_x, g_y);
+            if (o <= 0) continue;
+            total += o;
+            gx[i] += g_x; gx[j] -= g_x;
+            gy[i] += g_y; gy[j] -= g_y;
+        }
+        for (size_t f = 0; f < fixed_cx.size(); ++f) {
+            double g_x, g_y;
+            double o = pair_term(x[i] - fixed_cx[f], y[i] - fixed_cy[f],
+                                 half_w[i] + fixed_hw[f], half_w[i] + fixed_hh[f], g_x, g_y);
+            if (o <= 0) continue;
+            total += o;
+            gx[i] += g_x;
+            gy[i] += g_y;
+        }
+    }
+    return total;
+}
+
+// ----------------------------------------------------------------------
+// 中心限制: [s_len/2, Chip - s_len/2] (與 ILP 變數範圍相同)
+// ----------------------------------------------------------------------
+void AnalyticalPlacer::clampToChip(vector<double>& x, vector<double>& y) const {
+    for (int i = 0; i < n; ++i) {
+        x[i] = min(max(x[i], half_w[i]), data.chip_w - half_w[i]);
+        y[i] = min(max(y[i], half_w[i]), data.chip_h - half_w[i]);
+    }
+}
+
+// ----------------------------------------------------------------------
+// 儲存結果到 FloorplanData
+// ----------------------------------------------------------------------
+void AnalyticalPlacer::storeResults(const vector<double>& x, const vector<double>& y) {
+    for (int i = 0; i < n; ++i) {
+        setGlobalCenter(data.soft_modules[i], x[i], y[i]);
+    }
+}
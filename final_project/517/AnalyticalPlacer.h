@@ -0,0 +1,67 @@
+#ifndef ANALYTICALPLACER_H
+#define ANALYTICALPLACER_H
+
+#include <string>
+#include <vector>
+#include "Module.h" // 包含數據結構
+
+using namespace std;
+
+// 解析式全局放置器 (不需 Gurobi 授權)
+// 目標: Minimize  LSE-HPWL(x, y) + lambda * Overlap(x, y)
+//   - 先以二次線長 (Quadratic WL) + 共軛梯度 (CG) 求初始解
+//   - 再以 Nesterov 加速梯度法最小化平滑線長 + 重疊懲罰，逐步加大 lambda
+// 連線以 CSR (Compressed Sparse Row) 陣列儲存，每次迭代成本與連線數成正比
+// 結果寫回 FloorplanData，與 GlobalPlacer 相同，交給 LocalRefiner
+class AnalyticalPlacer {
+public:
+    FloorplanData& data; // 引用 FloorplanData
+
+    // 建構子
+    AnalyticalPlacer(FloorplanData& floorplan_data) : data(floorplan_data) {}
+
+    // 主要放置函數
+    void place();
+
+private:
+    int n = 0; // Soft Module 數量
+
+    // Soft-Soft 連線 (CSR, 對稱儲存: i->j 與 j->i 各一筆)
+    vector<int> row_ptr;
+    vector<int> col_idx;
+    vector<double> edge_w;
+
+    // Soft-Fixed 連線 (CSR, 每個 soft module 連到的 fixed 中心)
+    vector<int> anchor_ptr;
+    vector<double> anchor_x;
+    vector<double> anchor_y;
+    vector<double> anchor_w;
+
+    // 幾何 (半邊長)
+    vector<double> half_w; // soft: s_len / 2
+    vector<double> fixed_cx, fixed_cy, fixed_hw, fixed_hh;
+
+    double gamma = 1.0; // LSE 平滑參數
+
+    // 1. 建立 CSR 連線陣列
+    void buildCSR();
+
+    // 2. 二次線長初始解 (各維度獨立的 CG)
+    void solveQuadratic(vector<double>& pos, bool is_x);
+
+    // 3. 平滑線長 (LSE) 與其梯度
+    double wirelength(const vector<double>& x, const vector<double>& y,
+                      vector<double>& gx, vector<double>& gy) const;
+
+    // 4. 重疊懲罰 (soft-soft 與 soft-fixed 的重疊面積) 與其梯度
+    double overlap(const vector<double>& x, const vector<double>& y,
+                   vector<double>& gx, vector<double>& gy) const;
+
+    // 5. 將中心限制在 chip 範圍內
+    void clampToChip(vector<double>& x, vector<double>& y) const;
+
+    // 6. 儲存結果到 FloorplanData
+    void storeResults(const vector<double>& x, const vector<double>& y);
+};
+
+#endif // ANALYTICALPLACER_H
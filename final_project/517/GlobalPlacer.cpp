@@ -1,23 +1,11 @@
+#ifndef NO_GUROBI // 無 Gurobi 授權時整個檔案不編譯 (改用 AnalyticalPlacer)
+
 #include "GlobalPlacer.h"
 #include <iostream>
 #include <numeric>
 
 using namespace std;
 
-// ----------------------------------------------------------------------
-// 輔助函數: 取得模組變數的邊長
-// ----------------------------------------------------------------------
-double getModuleSize(const string& name, const FloorplanData& data) {
-    for (const auto& m : data.soft_modules) {
-        if (m.name == name) return m.s_len;
-    }
-    // 必須是 Fixed Module
-    for (const auto& m : data.fixed_modules) {
-        if (m.name == name) return m.s_len; 
-    }
-    return 0.0; // 應永遠不會發生
-}
-
 // ----------------------------------------------------------------------
 // 放置主函數
 // ----------------------------------------------------------------------
@@ -61,79 +49,81 @@ void GlobalPlacer::place() {
     cout << "--- Global Placement Finished ---" << endl;
 }
 
+// ----------------------------------------------------------------------
+// 輔助函數: 取出 addVars / addConstrs 回傳的陣列 (呼叫端負責 delete[])
+// ----------------------------------------------------------------------
+template <typename T>
+static vector<T> takeArray(T* arr, int len) {
+    vector<T> v(arr, arr + len);
+    delete[] arr;
+    return v;
+}
+
 // ----------------------------------------------------------------------
 // 執行 ILP 求解器
+// 所有變數與約束以陣列一次加入，只走實際存在的連線 (線性於連線數)
 // ----------------------------------------------------------------------
 void GlobalPlacer::runILPPlacement(GRBModel& model) {
     
     // 1. 變數定義 (Center Variables)
     double chip_w = data.chip_w;
     double chip_h = data.chip_h;
+    int n = data.soft_modules.size();
     
     // 定義 Soft Module 的中心點變數 (X/Y)
-    for (const auto& m : data.soft_modules) {
-        // Center_X 範圍: [s_len/2, ChipW - s_len/2]
-        double min_x = m.s_len / 2.0;
-        double max_x = chip_w - m.s_len / 2.0;
-        
-        x_vars[m.name] = model.addVar(min_x, max_x, 0.0, GRB_CONTINUOUS, "X_" + m.name);
-        y_vars[m.name] = model.addVar(min_x, max_x, 0.0, GRB_CONTINUOUS, "Y_" + m.name);
+    // Center 範圍: [s_len/2, Chip - s_len/2]
+    vector<double> lb_x(n), ub_x(n), lb_y(n), ub_y(n);
+    vector<char> types(n, GRB_CONTINUOUS);
+    vector<string> names_x(n), names_y(n);
+    for (int i = 0; i < n; ++i) {
+        const Module& m = data.soft_modules[i];
+        lb_x[i] = m.s_len / 2.0;
+        ub_x[i] = chip_w - m.s_len / 2.0;
+        lb_y[i] = m.s_len / 2.0;
+        ub_y[i] = chip_h - m.s_len / 2.0;
+        names_x[i] = "X_" + m.name;
+        names_y[i] = "Y_" + m.name;
     }
+    x_vars = takeArray(model.addVars(lb_x.data(), ub_x.data(), nullptr, types.data(), names_x.data(), n), n);
+    y_vars = takeArray(model.addVars(lb_y.data(), ub_y.data(), nullptr, types.data(), names_y.data(), n), n);
     
     // Fixed Module 的中心點是固定的 (僅用於連線計算，不需要變數)
     // 但為了統一 HPWL 計算，我們將 Fixed Module 的中心點作為常數項處理。
 
     // 2. 變數定義 (Distance Variables for HPWL)
-    // 遍歷所有模組對，計算連線數大於 0 的 pairs
-    for (size_t i = 0; i < data.soft_modules.size(); ++i) {
-        const Module& m_i = data.soft_modules[i];
-
-        // Soft-Soft Pairs
-        for (size_t j = i + 1; j < data.soft_modules.size(); ++j) {
-            const Module& m_j = data.soft_modules[j];
-
-            // 確定連線數量 (如果不存在，則為 0)
-            string name1 = m_i.name, name2 = m_j.name;
-            if (name1 > name2) swap(name1, name2);
-            pair<string, string> module_pair = {name1, name2};
-            
-            if (data.connections.count(module_pair) > 0) {
-                // 定義距離變數 dx, dy
-                GRBVar dx = model.addVar(0.0, chip_w, 0.0, GRB_CONTINUOUS, "DX_" + name1 + "_" + name2);
-                GRBVar dy = model.addVar(0.0, chip_h, 0.0, GRB_CONTINUOUS, "DY_" + name1 + "_" + name2);
-                
-                dx_vars[module_pair] = dx;
-                dy_vars[module_pair] = dy;
-            }
+    // 只針對至少一端為 soft 的連線 (Fixed-Fixed 距離是常數)
+    model_edges.clear();
+    for (size_t e = 0; e < data.edge_a.size(); ++e) {
+        if (data.edge_w[e] <= 0) continue;
+        if (data.isSoftId(data.edge_a[e]) || data.isSoftId(data.edge_b[e])) {
+            model_edges.push_back(e);
         }
+    }
+    int m_cnt = model_edges.size();
 
-        // Soft-Fixed Pairs
-        for (const auto& m_f : data.fixed_modules) {
-            string name1 = m_i.name, name2 = m_f.name;
-            if (name1 > name2) swap(name1, name2);
-            pair<string, string> module_pair = {name1, name2};
-
-            if (data.connections.count(module_pair) > 0) {
-                 // 定義距離變數 dx, dy
-                GRBVar dx = model.addVar(0.0, chip_w, 0.0, GRB_CONTINUOUS, "DX_" + name1 + "_" + name2);
-                GRBVar dy = model.addVar(0.0, chip_h, 0.0, GRB_CONTINUOUS, "DY_" + name1 + "_" + name2);
-                
-                dx_vars[module_pair] = dx;
-                dy_vars[module_pair] = dy;
-            }
-        }
+    // HPWL = Sum(NetCount * (dx + dy)): 係數直接設在變數的 obj 上
+    vector<double> lb_d(m_cnt, 0.0), ub_dx(m_cnt, chip_w), ub_dy(m_cnt, chip_h), obj_d(m_cnt);
+    vector<char> types_d(m_cnt, GRB_CONTINUOUS);
+    vector<string> names_dx(m_cnt), names_dy(m_cnt);
+    for (int k = 0; k < m_cnt; ++k) {
+        int e = model_edges[k];
+        const string& name1 = data.moduleById(data.edge_a[e]).name;
+        const string& name2 = data.moduleById(data.edge_b[e]).name;
+        obj_d[k] = data.edge_w[e];
+        names_dx[k] = "DX_" + name1 + "_" + name2;
+        names_dy[k] = "DY_" + name1 + "_" + name2;
     }
+    dx_vars = takeArray(model.addVars(lb_d.data(), ub_dx.data(), obj_d.data(), types_d.data(), names_dx.data(), m_cnt), m_cnt);
+    dy_vars = takeArray(model.addVars(lb_d.data(), ub_dy.data(), obj_d.data(), types_d.data(), names_dy.data(), m_cnt), m_cnt);
     
     // 3. 加入 HPWL 約束
-    GRBLinExpr obj_HPWL = 0;
-    addHPWLConstraints(model, obj_HPWL);
+    addHPWLConstraints(model);
     
     // 4. 加入重疊懲罰項
-    GRBLinExpr obj_Penalty = 0;
-    addOverlapPenalty(model, obj_Penalty);
+    addOverlapPenalty(model);
     
-    // 5. 設定目標函數: Minimize HPWL + Penalty
-    model.setObjective(obj_HPWL + obj_Penalty, GRB_MINIMIZE);
+    // 5. 設定目標函數: Minimize HPWL + Penalty (係數已在各變數的 obj 上)
+    model.set(GRB_IntAttr_ModelSense, GRB_MINIMIZE);
 
     // 6. 設定 Gurobi 參數
     model.set(GRB_IntParam_LogToConsole, 0); // 關閉控制台輸出 (可根據需要調整)
@@ -141,87 +131,65 @@ void GlobalPlacer::runILPPlacement(GRBModel& model) {
 
 // ----------------------------------------------------------------------
 // 實作 HPWL 線性化約束
+// |x1 - x2| <= dx  ->  dx - x1 + x2 >= 0  and  dx + x1 - x2 >= 0
 // ----------------------------------------------------------------------
-void GlobalPlacer::addHPWLConstraints(GRBModel& model, GRBLinExpr& obj_HPWL) {
+void GlobalPlacer::addHPWLConstraints(GRBModel& model) {
     cout << "  - Adding HPWL Constraints..." << endl;
-    
-    for (const auto& conn : data.connections) {
-        const pair<string, string>& module_pair = conn.first;
-        int net_count = conn.second;
-        
-        string name1 = module_pair.first;
-        string name2 = module_pair.second;
-        
-        // 查找距離變數
-        if (dx_vars.count(module_pair) == 0) continue;
-        GRBVar dx = dx_vars.at(module_pair);
-        GRBVar dy = dy_vars.at(module_pair);
 
-        // A. 處理 Soft-Soft 連線
-        if (x_vars.count(name1) && x_vars.count(name2)) {
-            GRBVar x1 = x_vars.at(name1);
-            GRBVar x2 = x_vars.at(name2);
-            GRBVar y1 = y_vars.at(name1);
-            GRBVar y2 = y_vars.at(name2);
+    int m_cnt = model_edges.size();
+    vector<GRBLinExpr> lhs;
+    vector<double> rhs;
+    vector<string> names;
+    lhs.reserve(4 * m_cnt);
+    rhs.reserve(4 * m_cnt);
+    names.reserve(4 * m_cnt);
 
-            // |x1 - x2| <= dx    ->  dx >= x1 - x2  and  dx >= x2 - x1
-            model.addConstr(dx >= x1 - x2, "DX_P_" + name1 + "_" + name2);
-            model.addConstr(dx >= x2 - x1, "DX_N_" + name1 + "_" + name2);
-            model.addConstr(dy >= y1 - y2, "DY_P_" + name1 + "_" + name2);
-            model.addConstr(dy >= y2 - y1, "DY_N_" + name1 + "_" + name2);
-        }
-        // B. 處理 Soft-Fixed 連線
-        else if (x_vars.count(name1) || x_vars.count(name2)) {
-            // 確定 Soft Module 和 Fixed Module 的變數/中心
-            GRBVar x_soft, y_soft;
-            double x_fixed, y_fixed;
-            string soft_name, fixed_name;
+    // 一端的座標: soft 為變數，fixed 為常數
+    auto coord = [&](int id, bool is_x) -> GRBLinExpr {
+        if (data.isSoftId(id)) return is_x ? x_vars[id] : y_vars[id];
+        const Module& f = data.moduleById(id);
+        return is_x ? f.fixed_x + f.fixed_w / 2.0 : f.fixed_y + f.fixed_h / 2.0;
+    };
 
-            if (x_vars.count(name1)) { // name1 是 Soft
-                x_soft = x_vars.at(name1);
-                y_soft = y_vars.at(name1);
-                soft_name = name1;
-                fixed_name = name2;
-            } else { // name2 是 Soft
-                x_soft = x_vars.at(name2);
-                y_soft = y_vars.at(name2);
-                soft_name = name2;
-                fixed_name = name1;
-            }
-            
-            // 查找 Fixed Module 的中心座標 (從 FloorplanData 中獲取)
-            const Module* m_f = data.getModuleByName(fixed_name);
-            if (!m_f) continue;
-            
-            x_fixed = m_f->fixed_x + m_f->fixed_w / 2.0;
-            y_fixed = m_f->fixed_y + m_f->fixed_h / 2.0;
+    // expr >= 0，常數項 (fixed 中心) 移到右手邊
+    auto add = [&](GRBLinExpr expr, const string& name) {
+        double c = expr.getConstant();
+        expr -= c;
+        lhs.push_back(expr);
+        rhs.push_back(-c);
+        names.push_back(name);
+    };
 
-            // |x_soft - x_fixed| <= dx
-            model.addConstr(dx >= x_soft - x_fixed, "DX_SF_P_" + soft_name + "_" + fixed_name);
-            model.addConstr(dx >= x_fixed - x_soft, "DX_SF_N_" + soft_name + "_" + fixed_name);
-            model.addConstr(dy >= y_soft - y_fixed, "DY_SF_P_" + soft_name + "_" + fixed_name);
-            model.addConstr(dy >= y_fixed - y_soft, "DY_SF_N_" + soft_name + "_" + fixed_name);
-        }
-        // C. Fixed-Fixed 連線 (不需要變數，距離是常數)
-        // 此處忽略，因為它們不會影響 HPWL 最小化目標。
+    for (int k = 0; k < m_cnt; ++k) {
+        int e = model_edges[k];
+        int a = data.edge_a[e], b = data.edge_b[e];
+        const string tag = data.moduleById(a).name + "_" + data.moduleById(b).name;
 
-        // 加入 HPWL 目標函數 (HPWL = Sum(NetCount * (dx + dy)))
-        obj_HPWL += net_count * (dx + dy);
+        GRBLinExpr dxa = coord(a, true) - coord(b, true);
+        GRBLinExpr dya = coord(a, false) - coord(b, false);
+
+        add(dx_vars[k] - dxa, "DX_P_" + tag);
+        add(dx_vars[k] + dxa, "DX_N_" + tag);
+        add(dy_vars[k] - dya, "DY_P_" + tag);
+        add(dy_vars[k] + dya, "DY_N_" + tag);
     }
+
+    vector<char> senses(lhs.size(), GRB_GREATER_EQUAL);
+    delete[] model.addConstrs(lhs.data(), senses.data(), rhs.data(), names.data(), lhs.size());
 }
 
 // ----------------------------------------------------------------------
 // 實作線性重疊懲罰項
 // Penalty = 2 * (Avg_Connection) * Sum(Overlap_x + Overlap_y)
 // ----------------------------------------------------------------------
-void GlobalPlacer::addOverlapPenalty(GRBModel& model, GRBLinExpr& obj_Penalty) {
+void GlobalPlacer::addOverlapPenalty(GRBModel& model) {
     
     // 1. 計算懲罰因子 P
     long long total_connections = 0;
-    for (const auto& conn : data.connections) {
-        total_connections += conn.second;
+    for (int w : data.edge_w) {
+        total_connections += w;
     }
-    size_t num_connections = data.connections.size();
+    size_t num_connections = data.edge_w.size();
     
     // 避免除以零，並設定懲罰因子
     double avg_connection = (num_connections > 0) ? (double)total_connections / num_connections : 1.0;
@@ -231,50 +199,43 @@ void GlobalPlacer::addOverlapPenalty(GRBModel& model, GRBLinExpr& obj_Penalty) {
     cout << "  - Adding Linear Overlap Penalty..." << endl;
     cout << "  - Penalty Factor (P): " << PENALTY_FACTOR << endl;
 
-    GRBLinExpr total_overlap_var = 0;
-    int overlap_counter = 0;
-    
     // 遍歷所有已定義距離變數的模組對 (Soft-Soft & Soft-Fixed)
-    for (const auto& entry : dx_vars) {
-        const pair<string, string>& module_pair = entry.first;
-        GRBVar dx = entry.second;
-        GRBVar dy = dy_vars.at(module_pair);
+    // 引入 Overlap 變數 O_x, O_y (連續變數, >= 0)，懲罰係數直接設在 obj 上
+    int m_cnt = model_edges.size();
+    vector<double> lb(m_cnt, 0.0), ub(m_cnt, GRB_INFINITY), obj(m_cnt), required_sep(m_cnt);
+    vector<char> types(m_cnt, GRB_CONTINUOUS);
+    vector<string> names_x(m_cnt), names_y(m_cnt);
+    for (int k = 0; k < m_cnt; ++k) {
+        int e = model_edges[k];
+        const Module& m1 = data.moduleById(data.edge_a[e]);
+        const Module& m2 = data.moduleById(data.edge_b[e]);
+        required_sep[k] = (m1.s_len + m2.s_len) / 2.0;
 
-        string name1 = module_pair.first;
-        string name2 = module_pair.second;
+        // 應用權重 (Soft-Fixed 對)
+        double current_weight = (m1.is_soft != m2.is_soft) ? WEIGHT_SF : 1.0;
+        obj[k] = PENALTY_FACTOR * current_weight;
+        names_x[k] = "OX_" + m1.name + "_" + m2.name;
+        names_y[k] = "OY_" + m1.name + "_" + m2.name;
+    }
+    vector<GRBVar> ox = takeArray(model.addVars(lb.data(), ub.data(), obj.data(), types.data(), names_x.data(), m_cnt), m_cnt);
+    vector<GRBVar> oy = takeArray(model.addVars(lb.data(), ub.data(), obj.data(), types.data(), names_y.data(), m_cnt), m_cnt);
 
-        // 查找模組的 s_len
-        double s1 = getModuleSize(name1, data);
-        double s2 = getModuleSize(name2, data);
-        double required_sep = (s1 + s2) / 2.0;
-        
-        // 引入 Overlap 變數 O_x, O_y (連續變數, >= 0)
-        string ox_name = "OX_" + name1 + "_" + name2;
-        string oy_name = "OY_" + name1 + "_" + name2;
-        GRBVar Ox = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, ox_name);
-        GRBVar Oy = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, oy_name);
-        
-        // 約束條件: Ox >= Required_Sep - Dx
-        // 這實現了 Ox = max(0, Required_Sep - Dx)
-        model.addConstr(Ox >= required_sep - dx, "OverlapX_" + name1 + "_" + name2);
-        model.addConstr(Oy >= required_sep - dy, "OverlapY_" + name1 + "_" + name2);
-        
-        // 應用權重
-        double current_weight = 1.0;
-        // 判斷是否為 Soft-Fixed 對 (如果其中一個模組在 fixed_modules 列表中，則為 SF)
-        bool is_sf = (data.getModuleByName(name1)->is_soft != data.getModuleByName(name2)->is_soft);
-        
-        if (is_sf) {
-             current_weight = WEIGHT_SF;
-        }
-        
-        total_overlap_var += current_weight * (Ox + Oy);
-        overlap_counter++;
+    // 約束條件: Ox >= Required_Sep - Dx  ->  Ox + Dx >= Required_Sep
+    // 這實現了 Ox = max(0, Required_Sep - Dx)
+    vector<GRBLinExpr> lhs(2 * m_cnt);
+    vector<double> rhs(2 * m_cnt);
+    vector<string> names(2 * m_cnt);
+    for (int k = 0; k < m_cnt; ++k) {
+        lhs[2 * k] = ox[k] + dx_vars[k];
+        lhs[2 * k + 1] = oy[k] + dy_vars[k];
+        rhs[2 * k] = rhs[2 * k + 1] = required_sep[k];
+        names[2 * k] = "OverlapX_" + names_x[k].substr(3);
+        names[2 * k + 1] = "OverlapY_" + names_y[k].substr(3);
     }
-    
-    // 最終懲罰項 = P * (所有 Overlap 變數的加權總和)
-    obj_Penalty = PENALTY_FACTOR * total_overlap_var;
-    cout << "  - Total Overlap Pairs modeled: " << overlap_counter << endl;
+    vector<char> senses(lhs.size(), GRB_GREATER_EQUAL);
+    delete[] model.addConstrs(lhs.data(), senses.data(), rhs.data(), names.data(), lhs.size());
+
+    cout << "  - Total Overlap Pairs modeled: " << m_cnt << endl;
 }
 
 
@@ -282,21 +243,14 @@ void GlobalPlacer::addOverlapPenalty(GRBModel& model, GRBLinExpr& obj_Penalty) {
 // 儲存結果到 FloorplanData
 // ----------------------------------------------------------------------
 void GlobalPlacer::storeResults(GRBModel& model) {
-    for (auto& m : data.soft_modules) {
-        if (x_vars.count(m.name)) {
-            // 獲取中心座標
-            double x_center = x_vars.at(m.name).get(GRB_DoubleAttr_X);
-            double y_center = y_vars.at(m.name).get(GRB_DoubleAttr_X);
-            
-            // 儲存 Global Placement 結果
-            m.global_center.x = (int)round(x_center);
-            m.global_center.y = (int)round(y_center);
-            
-            // 初始化 Local Placement 的 BBox
-            m.current_bbox.x_min = (int)round(x_center - m.s_len / 2.0);
-            m.current_bbox.y_min = (int)round(y_center - m.s_len / 2.0);
-            m.current_bbox.x_max = m.current_bbox.x_min + m.s_len;
-            m.current_bbox.y_max = m.current_bbox.y_min + m.s_len;
-        }
+    for (size_t i = 0; i < data.soft_modules.size() && i < x_vars.size(); ++i) {
+        // 獲取中心座標
+        double x_center = x_vars[i].get(GRB_DoubleAttr_X);
+        double y_center = y_vars[i].get(GRB_DoubleAttr_X);
+        
+        // 儲存 Global Placement 結果並初始化 Local Placement 的 BBox
+        setGlobalCenter(data.soft_modules[i], x_center, y_center);
     }
-}
\ No newline at end of file
+}
+
+#endif // NO_GUROBI
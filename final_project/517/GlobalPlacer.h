@@ -3,7 +3,6 @@
 
 #include <string>
 #include <vector>
-#include <map>
 #include <tuple>
 #include <gurobi_c++.h> // 包含 Gurobi 標頭檔
 #include "Module.h"     // 包含數據結構
@@ -22,23 +21,24 @@ public:
     void place();
 
 private:
-    // Gurobi 變數映射 (用於快速查找)
-    map<string, GRBVar> x_vars; // 模組中心 X 座標變數
-    map<string, GRBVar> y_vars; // 模組中心 Y 座標變數
+    // Gurobi 變數 (依 ID 存於陣列，不再以名稱查找)
+    vector<GRBVar> x_vars; // soft module i 的中心 X 座標變數
+    vector<GRBVar> y_vars; // soft module i 的中心 Y 座標變數
     
-    // Gurobi 距離變數映射 (用於 HPWL 線性化: |c_i - c_j|)
-    // 鍵值: {ModuleA, ModuleB} (按字母順序排列)
-    map<pair<string, string>, GRBVar> dx_vars; 
-    map<pair<string, string>, GRBVar> dy_vars; 
+    // Gurobi 距離變數 (用於 HPWL 線性化: |c_i - c_j|)
+    // 只針對實際存在且至少一端為 soft 的連線: model_edges[k] 為 data.edge_* 的索引
+    vector<int> model_edges;
+    vector<GRBVar> dx_vars; 
+    vector<GRBVar> dy_vars; 
 
     // 執行 ILP 求解
     void runILPPlacement(GRBModel& model);
 
     // 實作線性重疊懲罰項
-    void addOverlapPenalty(GRBModel& model, GRBLinExpr& obj_Penalty);
+    void addOverlapPenalty(GRBModel& model);
     
     // 實作 HPWL 線性化約束
-    void addHPWLConstraints(GRBModel& model, GRBLinExpr& obj_HPWL);
+    void addHPWLConstraints(GRBModel& model);
 
     // 儲存結果到 FloorplanData
     void storeResults(GRBModel& model);
@@ -1,5 +1,4 @@
 #include "LocalRefiner.h"
-#include <set>      // For std::set
 #include <utility>  // For std::pair (儘管通常包含在其他地方，顯式包含更安全)
 // ----------------------------------------------------------------------
 // 1. 初始化網格 (Initialization)
@@ -7,7 +6,7 @@
 
 void LocalRefiner::initializeGrid() {
     // 網格大小為 Chip 寬度 x 高度
-    grid.assign(data.chip_h, vector<int>(data.chip_w, 0));
+    grid.assign((size_t)data.chip_h * data.chip_w, 0);
     
     // 標記 Fixed Modules
     for (size_t i = 0; i < data.fixed_modules.size(); ++i) {
@@ -18,7 +17,7 @@ void LocalRefiner::initializeGrid() {
             for (int x = m.fixed_x; x < m.fixed_x + m.fixed_w; ++x) {
                 // 確保在 Chip 範圍內
                 if (x >= 0 && x < data.chip_w && y >= 0 && y < data.chip_h) {
-                    grid[y][x] = module_id;
+                    cell(x, y) = module_id;
                 }
             }
         }
@@ -27,16 +26,25 @@ void LocalRefiner::initializeGrid() {
     // 標記 Soft Modules 的初始 BBox
     for (size_t i = 0; i < data.soft_modules.size(); ++i) {
         auto& m = data.soft_modules[i];
-        int module_id = i + 1; // 使用正數 ID 標記 Soft Module
+        int module_id = m.id + 1; // 使用正數 ID 標記 Soft Module
 
         // 初始面積: 0.64 * min_area, 初始邊長 s_i^(0)
         // 由於 GlobalPlacer 已根據 s_len 初始化 BBox，我們使用 BBox 
+        // 每一列中連續的空格記為一段 run
         
-        for (int y = m.current_bbox.y_min; y < m.current_bbox.y_max; ++y) {
-            for (int x = m.current_bbox.x_min; x < m.current_bbox.x_max; ++x) {
-                if (x >= 0 && x < data.chip_w && y >= 0 && y < data.chip_h && grid[y][x] == 0) {
-                    grid[y][x] = module_id;
-                    m.occupied_cells.push_back({x, y});
+        m.occupied_runs.clear();
+        m.occupied_area = 0;
+        for (int y = max(0, m.current_bbox.y_min); y < min(data.chip_h, m.current_bbox.y_max); ++y) {
+            int run_start = -1;
+            for (int x = max(0, m.current_bbox.x_min); x <= min(data.chip_w, m.current_bbox.x_max); ++x) {
+                bool free_cell = (x < min(data.chip_w, m.current_bbox.x_max)) && cell(x, y) == 0;
+                if (free_cell) {
+                    cell(x, y) = module_id;
+                    if (run_start < 0) run_start = x;
+                } else if (run_start >= 0) {
+                    m.occupied_runs.push_back({run_start, y, x, y + 1});
+                    m.occupied_area += x - run_start;
+                    run_start = -1;
                 }
             }
         }
@@ -50,7 +58,7 @@ void LocalRefiner::initializeGrid() {
 
 bool LocalRefiner::isAreaConstraintSatisfied() {
     for (const auto& m : data.soft_modules) {
-        if (m.occupied_cells.size() < m.min_area) {
+        if (m.occupied_area < m.min_area) {
             return false;
         }
     }
@@ -70,13 +78,11 @@ vector<Direction> LocalRefiner::getExtensionOrdering(const Module& m) {
         double score = 0;
         // 根據方向判斷 BBox 之外的區域與哪些模組中心接近
         
-        for (const auto& conn : data.connections) {
-            const string& name1 = conn.first.first;
-            const string& name2 = conn.first.second;
-            int count = conn.second;
+        for (size_t e = 0; e < data.edge_a.size(); ++e) {
+            int count = data.edge_w[e];
             
-            const Module* other_m = data.getModuleByName(name1 == m.name ? name2 : name1);
-            if (!other_m || other_m->name == m.name) continue;
+            const Module* other_m = &data.moduleById(data.edge_a[e] == m.id ? data.edge_b[e] : data.edge_a[e]);
+            if (other_m->id == m.id) continue;
             
             Point other_center = other_m->is_soft ? other_m->global_center : other_m->global_center;
             
@@ -127,58 +133,48 @@ bool LocalRefiner::tryExtend(Module& m, Direction dir) {
     int x_max = m.current_bbox.x_max;
     int y_max = m.current_bbox.y_max;
     
-    vector<Point> potential_cells;
-    
-    // 確定要延伸的線段範圍
-    if (dir == RIGHT) {
-        int x_extend = x_max;
-        if (x_extend >= w) return false; // 碰到 chip 邊界
-        for (int y = y_min; y < y_max; ++y) { // 延伸整段 BBox 範圍 (y_min..y_max)
-            if (grid[y][x_extend] == 0) {
-                potential_cells.push_back({x_extend, y});
-            }
-        }
-    } 
-    else if (dir == LEFT) {
-        int x_extend = x_min - 1;
-        if (x_extend < 0) return false; // 碰到 chip 邊界
-        for (int y = y_min; y < y_max; ++y) {
-            if (grid[y][x_extend] == 0) {
-                potential_cells.push_back({x_extend, y});
-            }
-        }
+    // 確定要延伸的線段: 沿 (x0, y0) 往 (step_x, step_y) 走 len 格
+    int x0, y0, step_x, step_y, len;
+    if (dir == RIGHT || dir == LEFT) {
+        x0 = (dir == RIGHT) ? x_max : x_min - 1;
+        if (x0 < 0 || x0 >= w) return false; // 碰到 chip 邊界
+        y0 = y_min; step_x = 0; step_y = 1; len = y_max - y_min; // 延伸整段 BBox 範圍 (y_min..y_max)
+    } else {
+        y0 = (dir == UP) ? y_max : y_min - 1;
+        if (y0 < 0 || y0 >= h) return false; // 碰到 chip 邊界
+        x0 = x_min; step_x = 1; step_y = 0; len = x_max - x_min;
     }
-    else if (dir == UP) {
-        int y_extend = y_max;
-        if (y_extend >= h) return false; // 碰到 chip 邊界
-        for (int x = x_min; x < x_max; ++x) {
-            if (grid[y_extend][x] == 0) {
-                potential_cells.push_back({x, y_extend});
-            }
-        }
-    }
-    else if (dir == DOWN) {
-        int y_extend = y_min - 1;
-        if (y_extend < 0) return false; // 碰到 chip 邊界
-        for (int x = x_min; x < x_max; ++x) {
-            if (grid[y_extend][x] == 0) {
-                potential_cells.push_back({x, y_extend});
-            }
+
+    // 收集線段上連續的空格 (run)，只記錄段落而非每一格
+    vector<Rect> new_runs;
+    int run_start = -1;
+    for (int k = 0; k <= len; ++k) {
+        bool free_cell = (k < len) && cell(x0 + k * step_x, y0 + k * step_y) == 0;
+        if (free_cell) {
+            if (run_start < 0) run_start = k;
+        } else if (run_start >= 0) {
+            new_runs.push_back({x0 + run_start * step_x, y0 + run_start * step_y,
+                                x0 + k * step_x + step_y, y0 + k * step_y + step_x});
+            run_start = -1;
         }
     }
     
-    if (potential_cells.empty()) {
+    if (new_runs.empty()) {
         // 該方向整段皆被占據 (0 格可加) -> 該方向不可用
         return false;
     }
 
     // 執行延伸 (更新網格和 BBox)
-    int module_id = distance(data.soft_modules.begin(), find_if(data.soft_modules.begin(), data.soft_modules.end(), 
-                                                                [&](const Module& soft_m){ return soft_m.name == m.name; })) + 1;
+    int module_id = m.id + 1;
 
-    for (const auto& p : potential_cells) {
-        grid[p.y][p.x] = module_id;
-        m.occupied_cells.push_back(p);
+    for (const auto& r : new_runs) {
+        for (int y = r.y_min; y < r.y_max; ++y) {
+            for (int x = r.x_min; x < r.x_max; ++x) {
+                cell(x, y) = module_id;
+            }
+        }
+        m.occupied_area += (long long)(r.x_max - r.x_min) * (r.y_max - r.y_min);
+        m.occupied_runs.push_back(r);
     }
     
     // 更新 BBox
@@ -207,7 +203,7 @@ void LocalRefiner::runExtensionRounds() {
         
         // 依照 Global Ordering 進行 Round-Robin
         for (auto& m : data.soft_modules) {
-            if (m.occupied_cells.size() >= m.min_area) {
+            if (m.occupied_area >= m.min_area) {
                 continue; // 已達 minimum area 直接跳過
             }
             
@@ -231,7 +227,7 @@ void LocalRefiner::runExtensionRounds() {
         
         // 停止條件: 所有未達標 modules 回報「無法 extend」
         if (unextended_count == data.soft_modules.size() - count_if(data.soft_modules.begin(), data.soft_modules.end(), 
-                                                                    [](const Module& m){ return m.occupied_cells.size() >= m.min_area; })) {
+                                                                    [](const Module& m){ return m.occupied_area >= m.min_area; })) {
             cout << "  - Local Refinement stopped: Cannot extend remaining modules." << endl;
             break;
         }
@@ -250,14 +246,11 @@ void LocalRefiner::runExtensionRounds() {
 double LocalRefiner::calculateFinalHPWL() const {
     double total_hpwl = 0.0;
 
-    for (const auto& conn : data.connections) {
-        const string& name1 = conn.first.first;
-        const string& name2 = conn.first.second;
-        int count = conn.second;
+    for (size_t e = 0; e < data.edge_a.size(); ++e) {
+        int count = data.edge_w[e];
         
-        const Module* m1 = data.getModuleByName(name1);
-        const Module* m2 = data.getModuleByName(name2);
-        if (!m1 || !m2) continue;
+        const Module* m1 = &data.moduleById(data.edge_a[e]);
+        const Module* m2 = &data.moduleById(data.edge_b[e]);
         
         Point c1, c2;
 
@@ -298,29 +291,16 @@ const int dy[] = {0, 1, 0, -1};
 vector<Point> LocalRefiner::generateCorners(const Module& m) const {
     vector<Point> corners;
     
-    // 獲取模組 ID
-    // 由於 m 是 const 引用，我們需要手動查找 ID
-    int module_id = 0;
-    for (size_t i = 0; i < data.soft_modules.size(); ++i) {
-        if (data.soft_modules[i].name == m.name) {
-            module_id = i + 1;
-            break;
-        }
-    }
-    if (module_id == 0) return corners; // 找不到模組
-
-    // 將 occupied_cells 轉換為快速查找的 set
-    set<pair<int, int>> occupied_set;
-    for (const auto& p : m.occupied_cells) {
-        occupied_set.insert({p.x, p.y});
-    }
+    // 模組 ID (網格中 soft module 以 id + 1 標記)
+    if (m.id < 0) return corners; // 找不到模組
+    int module_id = m.id + 1;
 
     // 輔助函數: 檢查 (x, y) 格子是否被當前模組佔據
     auto is_occupied = [&](int x, int y) -> bool {
         // 檢查座標範圍
         if (x < 0 || x >= data.chip_w || y < 0 || y >= data.chip_h) return false;
         // 檢查 grid ID
-        return grid[y][x] == module_id;
+        return cell(x, y) == module_id;
     };
 
     // 1. 找到起始點 (最左下角的格子的左下角座標)
@@ -23,8 +23,10 @@ enum Direction {
 class LocalRefiner {
 private:
     FloorplanData& data;
-    // 網格: [y][x] 儲存 Module ID (0 代表未佔據)
-    vector<vector<int>> grid; 
+    // 網格: 一維陣列，cell(x, y) = grid[y * chip_w + x] 儲存 Module ID (0 代表未佔據)
+    vector<int> grid; 
+    int& cell(int x, int y) { return grid[(size_t)y * data.chip_w + x]; }
+    int cell(int x, int y) const { return grid[(size_t)y * data.chip_w + x]; }
     
     // 1. 初始化網格
     void initializeGrid();
@@ -12,17 +12,69 @@ double manhattanDistance(Point p1, Point p2) {
     return abs(p1.x - p2.x) + abs(p1.y - p2.y);
 }
 
-// 函數：根據名稱查找模組
+// 函數：儲存 Global Placement 結果並初始化 Local Placement 的 BBox
+void setGlobalCenter(Module& m, double x_center, double y_center) {
+    m.global_center.x = (int)round(x_center);
+    m.global_center.y = (int)round(y_center);
+
+    m.current_bbox.x_min = (int)round(x_center - m.s_len / 2.0);
+    m.current_bbox.y_min = (int)round(y_center - m.s_len / 2.0);
+    m.current_bbox.x_max = m.current_bbox.x_min + m.s_len;
+    m.current_bbox.y_max = m.current_bbox.y_min + m.s_len;
+}
+
+// 函數：根據名稱查找模組 (使用 module_id，O(1))
 const Module* FloorplanData::getModuleByName(const string& name) const {
-    // 查找 Soft Modules
-    for (const auto& m : soft_modules) {
-        if (m.name == name) return &m;
+    auto it = module_id.find(name);
+    if (it == module_id.end()) return nullptr;
+    return &moduleById(it->second);
+}
+
+// 函數：建立模組 ID 與連線的 CSR 鄰接
+void FloorplanData::buildIndex() {
+    module_id.clear();
+    module_id.reserve(numModules() * 2);
+    for (size_t i = 0; i < soft_modules.size(); ++i) {
+        soft_modules[i].id = i;
+        module_id[soft_modules[i].name] = i;
+    }
+    for (size_t k = 0; k < fixed_modules.size(); ++k) {
+        fixed_modules[k].id = soft_modules.size() + k;
+        module_id[fixed_modules[k].name] = fixed_modules[k].id;
     }
-    // 查找 Fixed Modules
-    for (const auto& m : fixed_modules) {
-        if (m.name == name) return &m;
+
+    // 連線轉為 ID (找不到名稱的連線略過)
+    edge_a.clear(); edge_b.clear(); edge_w.clear();
+    for (const auto& conn : connections) {
+        auto ia = module_id.find(conn.first.first);
+        auto ib = module_id.find(conn.first.second);
+        if (ia == module_id.end() || ib == module_id.end()) {
+            cerr << "Warning: connection references unknown module " << conn.first.first
+                 << " or " << conn.first.second << endl;
+            continue;
+        }
+        edge_a.push_back(ia->second);
+        edge_b.push_back(ib->second);
+        edge_w.push_back(conn.second);
+    }
+
+    // CSR: 先計數再填入
+    int n = numModules();
+    adj_ptr.assign(n + 1, 0);
+    for (size_t e = 0; e < edge_a.size(); ++e) {
+        adj_ptr[edge_a[e] + 1]++;
+        adj_ptr[edge_b[e] + 1]++;
+    }
+    for (int i = 0; i < n; ++i) adj_ptr[i + 1] += adj_ptr[i];
+    adj_idx.resize(adj_ptr[n]);
+    adj_w.resize(adj_ptr[n]);
+    vector<int> fill_pos(adj_ptr.begin(), adj_ptr.end() - 1);
+    for (size_t e = 0; e < edge_a.size(); ++e) {
+        adj_idx[fill_pos[edge_a[e]]] = edge_b[e];
+        adj_w[fill_pos[edge_a[e]]++] = edge_w[e];
+        adj_idx[fill_pos[edge_b[e]]] = edge_a[e];
+        adj_w[fill_pos[edge_b[e]]++] = edge_w[e];
     }
-    return nullptr;
 }
 
 // 函數：讀取輸入檔案
@@ -108,6 +160,9 @@ void FloorplanData::readInput(const string& filename) {
         }
     }
     
+    // 模組 ID 與 CSR 連線
+    buildIndex();
+
     // 簡化計算完成
     cout << "Input reading finished. Chip: " << chip_w << "x" << chip_h << endl;
     cout << "--- Input File Parsing Finished ---" << endl;
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <cmath>
 #include <algorithm>
 #include <utility> // for std::pair
@@ -26,6 +27,7 @@ struct Rect {
 
 // 模組結構
 struct Module {
+    int id = -1; // 穩定 ID (同 FloorplanData::module_id): soft = 0..S-1, fixed = S..
     string name;
     bool is_soft;
     long long min_area; // 使用 long long 處理大面積
@@ -38,7 +40,10 @@ struct Module {
     // Local Part 資訊
     Rect current_bbox; // 當前 BBox (x_min, y_min, x_max, y_max)
     vector<Point> corners; // 最終形狀的轉角座標
-    vector<Point> occupied_cells; // Local Part 追蹤佔據的網格座標
+    // Local Part 佔據狀態: 以 BBox + 連續格子段 (run) 記錄，不逐格存點
+    // 每段是 1 格寬的矩形 (一次延伸的一條邊上連續的空格)
+    vector<Rect> occupied_runs;
+    long long occupied_area = 0; // 佔據格數
     
     // Fixed Module 特有資訊
     int fixed_x;
@@ -54,13 +59,36 @@ struct FloorplanData {
     vector<Module> soft_modules;
     vector<Module> fixed_modules;
     map<pair<string, string>, int> connections; // 儲存 (ModuleA, ModuleB) -> NetCount
+
+    // 模組 ID (readInput 時建立): soft = 0..S-1, fixed = S..S+F-1
+    unordered_map<string, int> module_id;
+
+    // 連線以 ID 儲存，每個無序 pair 一筆 (順序與 connections 相同)
+    vector<int> edge_a, edge_b, edge_w;
+
+    // CSR 鄰接: adj_idx[adj_ptr[i] .. adj_ptr[i+1]) 為模組 i 的鄰居，adj_w 為連線數
+    vector<int> adj_ptr, adj_idx, adj_w;
     
     // 函數原型
     void readInput(const string& filename);
     const Module* getModuleByName(const string& name) const;
+
+    int numModules() const { return soft_modules.size() + fixed_modules.size(); }
+    bool isSoftId(int id) const { return id < (int)soft_modules.size(); }
+    const Module& moduleById(int id) const {
+        return isSoftId(id) ? soft_modules[id] : fixed_modules[id - soft_modules.size()];
+    }
+
+private:
+    // 建立 module_id / edge_* / adj_* (readInput 結尾呼叫)
+    void buildIndex();
 };
 
 // 函數：計算曼哈頓距離
 double manhattanDistance(Point p1, Point p2);
 
+// 函數：由 Global Placement 的中心座標初始化 global_center 與 s_len x s_len 的 BBox
+// (ILP 與 Analytical 兩種 Global Placer 共用，輸出給 LocalRefiner)
+void setGlobalCenter(Module& m, double x_center, double y_center);
+
 #endif // MODULE_H
\ No newline at end of file
@@ -2,15 +2,18 @@
 #include <string>
 #include <cstdlib>
 #include "Module.h"
+#ifndef NO_GUROBI
 #include "GlobalPlacer.h"
+#endif
+#include "AnalyticalPlacer.h"
 #include "LocalRefiner.h"
 
 using namespace std;
 
 int main(int argc, char *argv[]) {
     // 檢查命令行參數
-    if (argc != 3) {
-        cerr << "Usage: " << argv[0] << " [input_filename] [output_filename]" << endl;
+    if (argc != 3 && argc != 4) {
+        cerr << "Usage: " << argv[0] << " [input_filename] [output_filename] (ilp|analytical)" << endl;
 
         cerr << "Example: " << "./cadd0000 case01-input.txt case01-output.txt" << endl; 
         return 1;
@@ -18,6 +21,21 @@ int main(int argc, char *argv[]) {
     
     string input_filename = argv[1];
     string output_filename = argv[2];
+
+    // Global Placer 選擇: 預設使用 Gurobi ILP，未編入 Gurobi 時使用 Analytical
+#ifndef NO_GUROBI
+    string global_engine = (argc == 4) ? argv[3] : "ilp";
+#else
+    string global_engine = "analytical";
+    if (argc == 4 && string(argv[3]) != "analytical") {
+        cerr << "Built with NO_GUROBI: only the analytical global placer is available" << endl;
+        return 1;
+    }
+#endif
+    if (global_engine != "ilp" && global_engine != "analytical") {
+        cerr << "Unknown global placer: " << global_engine << " (ilp|analytical)" << endl;
+        return 1;
+    }
     
     cout << "======================================================" << endl;
     cout << "        ICCAD 2023 Problem D Floorplanner Start" << endl;
@@ -29,9 +47,17 @@ int main(int argc, char *argv[]) {
     FloorplanData data;
     data.readInput(input_filename);
     
-    // 2. Global Part: 建立初始拓樸 (使用 Gurobi)
-    GlobalPlacer placer(data);
-    placer.place();
+    // 2. Global Part: 建立初始拓樸 (Gurobi ILP 或 Analytical)
+    if (global_engine == "analytical") {
+        AnalyticalPlacer placer(data);
+        placer.place();
+    }
+#ifndef NO_GUROBI
+    else {
+        GlobalPlacer placer(data);
+        placer.place();
+    }
+#endif
     
     // 3. Local Part: 形狀生成與細部調整
     LocalRefiner refiner(data);
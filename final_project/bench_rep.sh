@@ -0,0 +1,69 @@
+#!/bin/bash
+# B*-tree vs sequence pair: run stage 1 (bin/fp) with --rep=btree and --rep=sp
+# on the same cases and record wall time, peak RSS, the exact HPWL measured by
+# bin/checker and whether the result is legal. Both runs get the same
+# annealing deadline, so a representation that packs faster also gets through
+# more of the schedule.
+#
+# Usage: ./bench_rep.sh [deadlineSeconds] [cases...]
+# Example: ./bench_rep.sh 120 input/case01-input.txt output/bench/gen1000-input.txt
+# Without cases the six contest inputs are used.
+set -euo pipefail
+
+DEADLINE="${1:-600}"
+shift $(( $# > 0 ? 1 : 0 ))
+CASES=("$@")
+if [ ${#CASES[@]} -eq 0 ]; then
+  CASES=(input/case0{1..6}-input.txt)
+fi
+
+BENCH_DIR="output/bench"
+RESULT_FILE="logs/bench_rep.csv"
+mkdir -p bin "$BENCH_DIR" logs
+
+make -s bin/fp checker
+
+# measure <log> <cmd...>: run cmd, print "seconds,peakMB,status"
+measure() {
+  python3 - "$@" <<'EOF'
+import resource, subprocess, sys, time
+log, cmd = sys.argv[1], sys.argv[2:]
+start = time.time()
+with open(log, "w") as f:
+    rc = subprocess.call(cmd, stdout=f, stderr=subprocess.STDOUT)
+status = "ok" if rc == 0 else "exit%d" % rc
+peak = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss / 1024.0
+print("%.3f,%.1f,%s" % (time.time() - start, peak, status))
+EOF
+}
+
+# check <input> <output>: "hpwl,legal|illegal|hpwl-mismatch" ("-,-" when there
+# is no output); hpwl-mismatch: legal, but the reported HPWL is wrong
+check() {
+  if [ ! -s "$2" ]; then
+    echo "-,-"
+    return
+  fi
+  local report verdict rc=0
+  report=$(./bin/checker "$1" "$2" 2>&1) || rc=$?
+  case $rc in
+    0) verdict="legal" ;;
+    3) verdict="hpwl-mismatch" ;;
+    *) verdict="illegal" ;;
+  esac
+  echo "$(echo "$report" | awk '$1 == "HPWL" { print $2 }'),$verdict"
+}
+
+echo "case,rep,seconds,peakMB,status,hpwl,check" >"$RESULT_FILE"
+for INPUT_FILE in "${CASES[@]}"; do
+  NAME=$(basename "$INPUT_FILE" .txt)
+  for REP in btree sp; do
+    OUTPUT_FILE="$BENCH_DIR/${NAME}_${REP}.out"
+    rm -f "$OUTPUT_FILE"
+    R=$(measure "logs/bench_rep_${NAME}_${REP}.log" ./bin/fp "$INPUT_FILE" "$OUTPUT_FILE" \
+        --rep="$REP" --deadline="$DEADLINE")
+    echo "$NAME,$REP,$R,$(check "$INPUT_FILE" "$OUTPUT_FILE")" | tee -a "$RESULT_FILE"
+  done
+done
+
+echo "Results written to $RESULT_FILE"
@@ -0,0 +1,91 @@
+#!/bin/bash
+# Scaling benchmark on generated cases (src/gen_case.cpp).
+#
+# For every size: generate a case, run stage 1 (bin/fp), stage 2 on its output
+# (bin/refiner) and the in-process pipeline (bin/pipeline), and record wall time
+# and peak RSS of each run. Every output is then run through bin/checker. A
+# stage that does not finish within the time limit is reported as "timeout";
+# stage 2 is skipped when stage 1 produced nothing.
+#
+# Usage: ./bench_scaling.sh [timeLimitSeconds] [seed] [sizes...]
+# Example: ./bench_scaling.sh 600 1 10 100 1000 10000
+# Extra generator options can be passed through GEN_OPTS, e.g.
+#   GEN_OPTS="--fixed=0.3 --rent=0.75" ./bench_scaling.sh
+set -euo pipefail
+
+LIMIT="${1:-600}"
+SEED="${2:-1}"
+shift $(( $# > 2 ? 2 : $# ))
+SIZES=("$@")
+if [ ${#SIZES[@]} -eq 0 ]; then
+  SIZES=(10 30 100 300 1000 3000 10000)
+fi
+
+BENCH_DIR="output/bench"
+RESULT_FILE="logs/bench_scaling.csv"
+mkdir -p bin "$BENCH_DIR" logs
+
+make -s bin/fp pipeline gen checker
+if [ ! -f bin/refiner ] || [ src/refiner_main.cpp -nt bin/refiner ]; then
+  g++ src/refiner_main.cpp -o bin/refiner -O3 -std=c++11 -pthread
+fi
+
+# measure <log> <cmd...>: run cmd with the time limit, print "seconds,peakMB,status"
+measure() {
+  python3 - "$LIMIT" "$@" <<'EOF'
+import resource, subprocess, sys, time
+limit, log, cmd = float(sys.argv[1]), sys.argv[2], sys.argv[3:]
+start = time.time()
+with open(log, "w") as f:
+    try:
+        rc = subprocess.call(cmd, stdout=f, stderr=subprocess.STDOUT, timeout=limit)
+        status = "ok" if rc == 0 else "exit%d" % rc
+    except subprocess.TimeoutExpired:
+        status = "timeout"
+peak = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss / 1024.0
+print("%.3f,%.1f,%s" % (time.time() - start, peak, status))
+EOF
+}
+
+# legality <input> <output>: "legal", "illegal", "hpwl-mismatch" (legal, but
+# the reported HPWL is wrong) or "-" when there is no output
+legality() {
+  if [ ! -s "$2" ]; then
+    echo "-"
+    return
+  fi
+  local rc=0
+  ./bin/checker "$1" "$2" >/dev/null 2>&1 || rc=$?
+  case $rc in
+    0) echo "legal" ;;
+    3) echo "hpwl-mismatch" ;;
+    *) echo "illegal" ;;
+  esac
+}
+
+echo "n,stage,seconds,peakMB,status,check" >"$RESULT_FILE"
+for N in "${SIZES[@]}"; do
+  INPUT_FILE="$BENCH_DIR/gen${N}-input.txt"
+  STAGE1_OUTPUT="$BENCH_DIR/gen${N}_stage1.out"
+  FINAL_OUTPUT="$BENCH_DIR/gen${N}.out"
+  PIPELINE_OUTPUT="$BENCH_DIR/gen${N}_pipeline.out"
+
+  # shellcheck disable=SC2086
+  ./bin/gen_case "$N" "$INPUT_FILE" --seed="$SEED" ${GEN_OPTS:-}
+
+  rm -f "$STAGE1_OUTPUT" "$FINAL_OUTPUT" "$PIPELINE_OUTPUT"
+  R=$(measure "logs/bench_fp_${N}.log" ./bin/fp "$INPUT_FILE" "$STAGE1_OUTPUT")
+  echo "$N,fp,$R,$(legality "$INPUT_FILE" "$STAGE1_OUTPUT")" | tee -a "$RESULT_FILE"
+
+  if [[ "$R" == *",ok" ]] && [ -s "$STAGE1_OUTPUT" ]; then
+    R=$(measure "logs/bench_refiner_${N}.log" ./bin/refiner "$INPUT_FILE" "$STAGE1_OUTPUT" "$FINAL_OUTPUT")
+  else
+    R="0,0,skipped"
+  fi
+  echo "$N,refiner,$R,$(legality "$INPUT_FILE" "$FINAL_OUTPUT")" | tee -a "$RESULT_FILE"
+
+  R=$(measure "logs/bench_pipeline_${N}.log" ./bin/pipeline "$INPUT_FILE" "$PIPELINE_OUTPUT" 1 1)
+  echo "$N,pipeline,$R,$(legality "$INPUT_FILE" "$PIPELINE_OUTPUT")" | tee -a "$RESULT_FILE"
+done
+
+echo "Results written to $RESULT_FILE"
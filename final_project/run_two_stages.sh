@@ -23,7 +23,7 @@ IMAGE_FILE="output/case${CASE_NUM}.png"
 
 # Stage 1 Source Files
 STAGE1_TARGET="bin/fp"
-STAGE1_SRCS="src/main.cpp src/floorplanner.cpp src/tree.cpp"
+STAGE1_SRCS="src/main.cpp src/floorplanner.cpp src/tree.cpp src/seqpair.cpp"
 
 # Stage 2 Source File
 REFINER_TARGET="bin/refiner"
@@ -59,7 +59,7 @@ fi
 if [ ! -f "$REFINER_TARGET" ] || [ "$REFINER_SRC" -nt "$REFINER_TARGET" ]; then
     echo "[Step 0b] Compiling Stage 2 (Refiner)..."
     if [ -f "$REFINER_SRC" ]; then
-        g++ "$REFINER_SRC" -o "$REFINER_TARGET" -O3 -std=c++11
+        g++ "$REFINER_SRC" -o "$REFINER_TARGET" -O3 -std=c++11 -pthread
     else
         echo "Error: $REFINER_SRC not found."
         exit 1
@@ -85,8 +85,8 @@ fi
 # Step 2: Run Refiner (Stage 2)
 # ==========================================
 echo "[Step 2] Running Refiner..."
-# Usage: ./refiner <original_input> <stage1_output> <final_output>
-$REFINER_TARGET "$INPUT_FILE" "$STAGE1_OUTPUT" "$FINAL_OUTPUT"
+# Usage: ./refiner <original_input> <stage1_output> <final_output> [threads]
+$REFINER_TARGET "$INPUT_FILE" "$STAGE1_OUTPUT" "$FINAL_OUTPUT" "$(nproc)"
 
 if [ $? -eq 0 ]; then
     echo "Stage 2 completed. Final Output: $FINAL_OUTPUT"
@@ -0,0 +1,436 @@
+// checker.cpp
+// Legality and HPWL checker for Problem D outputs.
+//
+//   - Output format: HPWL <value>, SOFTMODULE <n>, then per module
+//     "<name> <k>" followed by k corner lines "x y" (rectilinear polygon).
+//   - Per soft module: rectilinear polygon, inside the chip, area >= minimum
+//     area (shoelace), bounding box aspect ratio in [0.5, 2], and polygon area
+//     >= 80% of its bounding box area.
+//   - Non-overlap of all soft and fixed modules: a sweep line over the vertical
+//     polygon edges in x, with a max/add segment tree over compressed y. At equal
+//     x the closing edges are removed before opening edges are added, so modules
+//     that only touch are legal. O(E log E) for E edges in total.
+//   - HPWL is recomputed exactly from bounding box centers (in half units) and
+//     compared with the reported value.
+//
+// Build:
+//   make checker
+// Run:
+//   ./bin/checker <input.txt> <result.out>
+// Exit status 0 if the output is legal, 2 if not, 3 if it is legal but the
+// reported HPWL does not match the recomputed one.
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <climits>
+#include <stdexcept>
+
+#include "refiner.h"
+
+using namespace std;
+
+static const double minAspect = 0.5;
+static const double maxAspect = 2.0;
+static const double minRectRatio = 0.8;
+static const int maxReported = 20; // violation lines printed per run
+
+struct Polygon
+{
+    vector<long long> x, y; // corners, counter-clockwise after readOutput()
+    long long x1 = 0, y1 = 0, x2 = 0, y2 = 0; // bounding box
+    long long area = 0;
+    bool seen = false;
+};
+
+struct Violations
+{
+    int count = 0;
+    void report(const string &msg)
+    {
+        if (count < maxReported)
+            cout << "VIOLATION: " << msg << endl;
+        else if (count == maxReported)
+            cout << "(further violations not shown)" << endl;
+        ++count;
+    }
+};
+
+// Vertical edge of a polygon; open = polygon interior starts at x
+struct SweepEdge
+{
+    long long x;
+    int y1, y2; // compressed, half-open [y1, y2)
+    bool open;
+    int module;
+};
+
+// Range add / range max over elementary y intervals
+class CoverTree
+{
+public:
+    explicit CoverTree(int n) : _n(std::max(1, n)), _mx(4 * _n, 0), _add(4 * _n, 0) {}
+
+    void add(int l, int r, int v) { add(1, 0, _n, l, r, v); }
+    int max(int l, int r) const { return max(1, 0, _n, l, r); }
+
+private:
+    int _n;
+    vector<int> _mx, _add;
+
+    void add(int node, int lo, int hi, int l, int r, int v)
+    {
+        if (r <= lo || hi <= l)
+            return;
+        if (l <= lo && hi <= r)
+        {
+            _mx[node] += v;
+            _add[node] += v;
+            return;
+        }
+        const int mid = (lo + hi) / 2;
+        add(2 * node, lo, mid, l, r, v);
+        add(2 * node + 1, mid, hi, l, r, v);
+        _mx[node] = _add[node] + std::max(_mx[2 * node], _mx[2 * node + 1]);
+    }
+
+    int max(int node, int lo, int hi, int l, int r) const
+    {
+        if (r <= lo || hi <= l)
+            return INT_MIN / 2; // counts below an ancestor's add can be negative
+        if (l <= lo && hi <= r)
+            return _mx[node];
+        const int mid = (lo + hi) / 2;
+        return _add[node] + std::max(max(2 * node, lo, mid, l, r), max(2 * node + 1, mid, hi, l, r));
+    }
+};
+
+static Polygon rectPolygon(const refine2::Rect &r)
+{
+    Polygon p;
+    p.x = {r.x1, r.x2, r.x2, r.x1};
+    p.y = {r.y1, r.y1, r.y2, r.y2};
+    p.x1 = r.x1;
+    p.y1 = r.y1;
+    p.x2 = r.x2;
+    p.y2 = r.y2;
+    p.area = 1LL * (r.x2 - r.x1) * (r.y2 - r.y1);
+    return p;
+}
+
+// True if corner b is a repeat of a or lies on the straight edge a-b-c
+static bool redundantCorner(long long ax, long long ay, long long bx, long long by, long long cx, long long cy)
+{
+    return (ax == bx && ay == by) || (ax == bx && bx == cx) || (ay == by && by == cy);
+}
+
+// Remove repeated corners and corners in the middle of a straight edge (the
+// pixel refiner writes those), so that only real turns are left. Linear: a
+// stack pass, then the same test across the wrap-around.
+static void dropRedundantCorners(Polygon &p)
+{
+    vector<long long> x, y;
+    for (size_t c = 0; c < p.x.size(); ++c)
+    {
+        if (!x.empty() && x.back() == p.x[c] && y.back() == p.y[c])
+            continue;
+        while (x.size() >= 2 &&
+               redundantCorner(x[x.size() - 2], y[y.size() - 2], x.back(), y.back(), p.x[c], p.y[c]))
+        {
+            x.pop_back();
+            y.pop_back();
+        }
+        x.push_back(p.x[c]);
+        y.push_back(p.y[c]);
+    }
+    size_t first = 0;
+    bool changed = true;
+    while (changed && x.size() - first >= 3)
+    {
+        changed = false;
+        const size_t k = x.size();
+        if (redundantCorner(x[k - 2], y[k - 2], x[k - 1], y[k - 1], x[first], y[first]))
+        {
+            x.pop_back();
+            y.pop_back();
+            changed = true;
+        }
+        else if (redundantCorner(x[k - 1], y[k - 1], x[first], y[first], x[first + 1], y[first + 1]))
+        {
+            ++first;
+            changed = true;
+        }
+    }
+    p.x.assign(x.begin() + first, x.end());
+    p.y.assign(y.begin() + first, y.end());
+}
+
+// Read the soft module polygons of an output file; polys is indexed like pb.soft.
+// Returns the reported HPWL (or -1 if the file has none). Format errors throw.
+static double readOutput(const string &path, const refine2::Problem &pb, vector<Polygon> &polys,
+                         Violations &viol)
+{
+    ifstream in(path);
+    if (!in)
+        throw runtime_error("Cannot open output file: " + path);
+
+    unordered_map<string, int> softId;
+    for (size_t i = 0; i < pb.soft.size(); ++i)
+        softId[pb.soft[i].name] = (int)i;
+    polys.assign(pb.soft.size(), Polygon());
+
+    double reported = -1.0;
+    string tok;
+    in >> tok;
+    if (tok == "HPWL")
+    {
+        in >> reported;
+        in >> tok;
+    }
+    if (tok != "SOFTMODULE")
+        throw runtime_error("Expected SOFTMODULE in " + path);
+    int n = 0;
+    in >> n;
+
+    for (int m = 0; m < n; ++m)
+    {
+        string name;
+        int k = 0;
+        if (!(in >> name >> k) || k < 0)
+            throw runtime_error("Bad module header in " + path);
+        Polygon p;
+        p.x.resize(k);
+        p.y.resize(k);
+        for (int c = 0; c < k; ++c)
+            if (!(in >> p.x[c] >> p.y[c]))
+                throw runtime_error("Truncated corner list of " + name);
+
+        auto it = softId.find(name);
+        if (it == softId.end())
+        {
+            viol.report("unknown module " + name);
+            continue;
+        }
+        Polygon &slot = polys[it->second];
+        if (slot.seen)
+        {
+            viol.report("module " + name + " placed twice");
+            continue;
+        }
+
+        dropRedundantCorners(p);
+        k = (int)p.x.size();
+        if (k < 4 || k % 2 != 0)
+        {
+            viol.report(name + ": polygon needs an even number (>= 4) of corners");
+            continue;
+        }
+        bool rectilinear = true;
+        long long twiceArea = 0;
+        for (int c = 0; c < k; ++c)
+        {
+            const int d = (c + 1) % k;
+            const bool horizontal = p.y[c] == p.y[d] && p.x[c] != p.x[d];
+            const bool vertical = p.x[c] == p.x[d] && p.y[c] != p.y[d];
+            if (!horizontal && !vertical)
+                rectilinear = false;
+            twiceArea += p.x[c] * p.y[d] - p.x[d] * p.y[c];
+        }
+        if (!rectilinear)
+        {
+            viol.report(name + ": polygon is not rectilinear");
+            continue;
+        }
+        if (twiceArea < 0)
+        {
+            reverse(p.x.begin(), p.x.end());
+            reverse(p.y.begin(), p.y.end());
+            twiceArea = -twiceArea;
+        }
+        p.area = twiceArea / 2;
+        p.x1 = *min_element(p.x.begin(), p.x.end());
+        p.x2 = *max_element(p.x.begin(), p.x.end());
+        p.y1 = *min_element(p.y.begin(), p.y.end());
+        p.y2 = *max_element(p.y.begin(), p.y.end());
+        p.seen = true;
+        slot = p;
+    }
+    for (size_t i = 0; i < pb.soft.size(); ++i)
+        if (!polys[i].seen)
+            viol.report("module " + pb.soft[i].name + " missing from output");
+    return reported;
+}
+
+static void checkShapes(const refine2::Problem &pb, const vector<Polygon> &polys, Violations &viol)
+{
+    for (size_t i = 0; i < polys.size(); ++i)
+    {
+        const Polygon &p = polys[i];
+        if (!p.seen)
+            continue;
+        const string &name = pb.soft[i].name;
+        const long long w = p.x2 - p.x1, h = p.y2 - p.y1;
+
+        if (p.x1 < 0 || p.y1 < 0 || p.x2 > pb.W || p.y2 > pb.H)
+            viol.report(name + ": outside the chip");
+        if (p.area < pb.soft[i].minArea)
+            viol.report(name + ": area " + to_string(p.area) + " < minimum " + to_string(pb.soft[i].minArea));
+        const double aspect = (double)h / (double)w;
+        if (aspect < minAspect || aspect > maxAspect)
+            viol.report(name + ": aspect ratio " + to_string(aspect) + " outside [0.5, 2]");
+        if ((double)p.area < minRectRatio * (double)w * (double)h)
+            viol.report(name + ": fills less than 80% of its bounding box");
+    }
+}
+
+// Name of module id (soft first, then fixed) for messages
+static const string &moduleName(const refine2::Problem &pb, int id)
+{
+    const int n = (int)pb.soft.size();
+    return id < n ? pb.soft[id].name : pb.fixed[id - n].name;
+}
+
+static void checkOverlap(const refine2::Problem &pb, const vector<Polygon> &all, Violations &viol)
+{
+    vector<long long> ys;
+    for (const Polygon &p : all)
+        if (p.seen)
+            ys.insert(ys.end(), p.y.begin(), p.y.end());
+    sort(ys.begin(), ys.end());
+    ys.erase(unique(ys.begin(), ys.end()), ys.end());
+    auto yIndex = [&](long long y)
+    {
+        return (int)(lower_bound(ys.begin(), ys.end(), y) - ys.begin());
+    };
+
+    // Counter-clockwise polygons: a downward edge opens the interior to its
+    // right, an upward edge closes it
+    vector<SweepEdge> edges;
+    for (size_t m = 0; m < all.size(); ++m)
+    {
+        const Polygon &p = all[m];
+        if (!p.seen)
+            continue;
+        const size_t k = p.x.size();
+        for (size_t c = 0; c < k; ++c)
+        {
+            const size_t d = (c + 1) % k;
+            if (p.x[c] != p.x[d])
+                continue;
+            SweepEdge e;
+            e.x = p.x[c];
+            e.open = p.y[d] < p.y[c];
+            e.y1 = yIndex(min(p.y[c], p.y[d]));
+            e.y2 = yIndex(max(p.y[c], p.y[d]));
+            e.module = (int)m;
+            edges.push_back(e);
+        }
+    }
+    sort(edges.begin(), edges.end(), [](const SweepEdge &a, const SweepEdge &b)
+         { return a.x != b.x ? a.x < b.x : (a.open < b.open); });
+
+    CoverTree cover((int)ys.size());
+    vector<bool> reported(all.size(), false);
+    for (const SweepEdge &e : edges)
+    {
+        if (!e.open)
+        {
+            cover.add(e.y1, e.y2, -1);
+            continue;
+        }
+        if (cover.max(e.y1, e.y2) > 0 && !reported[e.module])
+        {
+            // Rare path: find who is already there by brute force over bounding boxes
+            reported[e.module] = true;
+            const Polygon &p = all[e.module];
+            string others;
+            for (size_t o = 0; o < all.size(); ++o)
+            {
+                const Polygon &q = all[o];
+                if ((int)o != e.module && q.seen &&
+                    q.x1 < p.x2 && p.x1 < q.x2 && q.y1 < p.y2 && p.y1 < q.y2)
+                    others += (others.empty() ? "" : ", ") + moduleName(pb, (int)o);
+            }
+            viol.report(moduleName(pb, e.module) + " overlaps " + (others.empty() ? string("itself") : others));
+        }
+        cover.add(e.y1, e.y2, +1);
+    }
+}
+
+// Twice the HPWL, from bounding box centers in half units (exact)
+static long long twiceHpwl(const refine2::Problem &pb, const vector<Polygon> &all)
+{
+    long long s = 0;
+    for (const refine2::Connection &c : pb.conns)
+    {
+        const Polygon &a = all[c.a];
+        const Polygon &b = all[c.b];
+        if (!a.seen || !b.seen)
+            continue;
+        const long long dx = llabs((a.x1 + a.x2) - (b.x1 + b.x2));
+        const long long dy = llabs((a.y1 + a.y2) - (b.y1 + b.y2));
+        s += (dx + dy) * c.w;
+    }
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        cerr << "Usage: " << argv[0] << " <input.txt> <result.out>" << endl;
+        return 1;
+    }
+
+    auto start_time = chrono::high_resolution_clock::now();
+
+    Violations viol;
+    long long hpwl2 = 0;
+    double reported = -1.0;
+    try
+    {
+        refine2::Problem pb = refine2::parse_input_problem(argv[1]);
+
+        vector<Polygon> all;
+        reported = readOutput(argv[2], pb, all, viol);
+        checkShapes(pb, all, viol);
+        for (const refine2::FixedMod &f : pb.fixed)
+        {
+            all.push_back(rectPolygon(f.r));
+            all.back().seen = true;
+        }
+        checkOverlap(pb, all, viol);
+        hpwl2 = twiceHpwl(pb, all);
+    }
+    catch (const exception &e)
+    {
+        cerr << "ERROR: " << e.what() << endl;
+        return 1;
+    }
+
+    auto end_time = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::microseconds>(end_time - start_time);
+
+    const double hpwl = 0.5 * (double)hpwl2;
+    bool mismatch = false;
+    cout << fixed << setprecision(1) << "HPWL " << hpwl;
+    if (reported >= 0)
+    {
+        cout << " (reported " << reported << ")";
+        mismatch = fabs(reported - hpwl) > max(1.0, 1e-6 * hpwl);
+        if (mismatch)
+            cout << " MISMATCH";
+    }
+    cout << endl;
+    cout << "Violations: " << viol.count << endl;
+    cout << setprecision(3) << "Time taken: " << duration.count() * 0.001 << " ms" << endl;
+    if (viol.count != 0)
+        return 2;
+    return mismatch ? 3 : 0;
+}
@@ -5,10 +5,37 @@
 #include <cmath>
 #include <algorithm>
 #include <iomanip>
+#include <cstdio>
 #include "floorplanner.h"
 
 using namespace std;
 
+volatile sig_atomic_t Floorplanner::_stopRequested = 0;
+
+template <>
+Tree &Floorplanner::rep<Tree>() { return *_tree; }
+template <>
+SeqPair &Floorplanner::rep<SeqPair>() { return *_seqPair; }
+
+// Rolls one SA move back on rejection: Tree is copied before the move,
+// SeqPair swaps its logged entries back
+template <class Rep>
+struct MoveUndo
+{
+    Rep &rep;
+    Rep saved;
+    MoveUndo(Rep &r) : rep(r), saved(r) {}
+    void restore() { rep = saved; }
+};
+
+template <>
+struct MoveUndo<SeqPair>
+{
+    SeqPair &rep;
+    MoveUndo(SeqPair &r) : rep(r) { rep.clearUndo(); }
+    void restore() { rep.undo(); }
+};
+
 // 1. Parsing Logic
 void Floorplanner::parseInput(fstream &inputFile)
 {
@@ -134,14 +161,35 @@ void Floorplanner::parseInput(fstream &inputFile)
 
     // Pass the fixed modules to the tree for contour initialization
     _tree->setFixedModules(&_fixed_modules);
+    _tree->setRng(&_rng);
+}
+
+void Floorplanner::useSequencePair()
+{
+    if (!_seqPair)
+        _seqPair = new SeqPair(_soft_modules);
+    // fixed modules are pre-placed against the cluster offset
+    _seqPair->setFixedModules(&_fixed_modules, &_offsetX, &_offsetY);
+    _seqPair->setRng(&_rng);
 }
 
 void Floorplanner::floorplan()
 {
-    _tree->buildInitial();
+    if (_seqPair)
+        _seqPair->buildInitial();
+    else
+        _tree->buildInitial();
     simulatedAnnealing();
 }
 
+void Floorplanner::packCurrent()
+{
+    if (_seqPair)
+        _seqPair->pack();
+    else
+        _tree->pack();
+}
+
 // 2. Cost Calculation
 double Floorplanner::computeArea()
 {
@@ -201,11 +249,17 @@ double Floorplanner::computeWirelength()
 }
 
 double Floorplanner::computeFixedOverlapPenalty()
+{
+    return computeFixedOverlapPenaltyT<true>();
+}
+
+template <bool HasGhosts>
+double Floorplanner::computeFixedOverlapPenaltyT()
 {
     double totalOverlap = 0;
     for (const auto &soft : _soft_modules)
     {
-        if (soft.isGhost())
+        if (HasGhosts && soft.isGhost())
             continue;
 
         // APPLY OFFSET HERE
@@ -255,12 +309,39 @@ double Floorplanner::computeBoundaryPenalty()
     return totalViolation;
 }
 
+// Bit 2: area term, bit 1: ghost blocks, bit 0: fixed modules
+int Floorplanner::costConfig() const
+{
+    bool hasGhosts = false;
+    for (const auto &b : _soft_modules)
+        hasGhosts = hasGhosts || b.isGhost();
+    return (_alpha != 0 ? 4 : 0) | (hasGhosts ? 2 : 0) | (_fixed_modules.empty() ? 0 : 1);
+}
+
 double Floorplanner::computeCost()
+{
+    switch (costConfig())
+    {
+    case 0: return computeCostT<false, false, false>();
+    case 1: return computeCostT<false, false, true>();
+    case 2: return computeCostT<false, true, false>();
+    case 3: return computeCostT<false, true, true>();
+    case 4: return computeCostT<true, false, false>();
+    case 5: return computeCostT<true, false, true>();
+    case 6: return computeCostT<true, true, false>();
+    default: return computeCostT<true, true, true>();
+    }
+}
+
+// A dead term contributes exactly 0 to the sum it is left out of, so every
+// instantiation returns the same value as the full formula
+template <bool UseArea, bool HasGhosts, bool HasFixed>
+double Floorplanner::computeCostT()
 {
     double W = computeWirelength();
-    double Area = computeArea(); // Optional, but usually good to keep area tight
+    double Area = UseArea ? computeArea() : 0.0; // Optional, but usually good to keep area tight
     double Boundary = computeBoundaryPenalty();
-    double Overlap = computeFixedOverlapPenalty();
+    double Overlap = HasFixed ? computeFixedOverlapPenaltyT<HasGhosts>() : 0.0;
 
     // Avoid division by zero
     double nW = (_normWL > 0) ? _normWL : 1.0;
@@ -272,7 +353,13 @@ double Floorplanner::computeCost()
     // Note: The contest only cares about WL, but during annealing we need Area to guide packing.
     // _gamma and _delta should be very large.
 
-    return _alpha * (Area / nA) + (1.0 - _alpha) * (W / nW) + _gamma * (Boundary / nB) + _delta * (Overlap / nO);
+    double cost = (1.0 - _alpha) * (W / nW);
+    if (UseArea)
+        cost = _alpha * (Area / nA) + cost;
+    cost += _gamma * (Boundary / nB);
+    if (HasFixed)
+        cost += _delta * (Overlap / nO);
+    return cost;
 }
 
 void Floorplanner::computeNormalizationFactors(double &areaNorm, double &wlNorm,
@@ -282,10 +369,19 @@ void Floorplanner::computeNormalizationFactors(double &areaNorm, double &wlNorm,
 
     for (int i = 0; i < sampleSize; ++i)
     {
-        _tree->rotateRandom();
-        _tree->deleteAndInsert();
-        _tree->resizeRandom(); // Don't forget resize!
-        _tree->pack();
+        if (_seqPair)
+        {
+            _seqPair->rotateRandom();
+            _seqPair->deleteAndInsert();
+            _seqPair->resizeRandom();
+        }
+        else
+        {
+            _tree->rotateRandom();
+            _tree->deleteAndInsert();
+            _tree->resizeRandom(); // Don't forget resize!
+        }
+        packCurrent();
 
         totalArea += computeArea();
         totalWL += computeWirelength();
@@ -303,6 +399,33 @@ void Floorplanner::computeNormalizationFactors(double &areaNorm, double &wlNorm,
 // 3. Simulated Annealing
 void Floorplanner::simulatedAnnealing()
 {
+    if (_seqPair)
+        simulatedAnnealingFor<SeqPair>();
+    else
+        simulatedAnnealingFor<Tree>();
+}
+
+template <class Rep>
+void Floorplanner::simulatedAnnealingFor()
+{
+    switch (costConfig())
+    {
+    case 0: simulatedAnnealingT<Rep, false, false, false>(); break;
+    case 1: simulatedAnnealingT<Rep, false, false, true>(); break;
+    case 2: simulatedAnnealingT<Rep, false, true, false>(); break;
+    case 3: simulatedAnnealingT<Rep, false, true, true>(); break;
+    case 4: simulatedAnnealingT<Rep, true, false, false>(); break;
+    case 5: simulatedAnnealingT<Rep, true, false, true>(); break;
+    case 6: simulatedAnnealingT<Rep, true, true, false>(); break;
+    default: simulatedAnnealingT<Rep, true, true, true>(); break;
+    }
+}
+
+template <class Rep, bool UseArea, bool HasGhosts, bool HasFixed>
+void Floorplanner::simulatedAnnealingT()
+{
+    Rep &current = rep<Rep>();
+
     double T = 10000.0;
     // const double T_min = 0.1;
     const double T_min = 1e-5; // 1e-5 and 1e-6 both result in roughly similar quality
@@ -318,67 +441,50 @@ void Floorplanner::simulatedAnnealing()
     if (iterations < 100)
         iterations = 100;
 
-    // Normalization
-    computeNormalizationFactors(_normArea, _normWL, _normBoundary, _normOverlap, 50);
+    // Normalization (a checkpoint carries its own, and the state and T to go on from)
+    if (!_checkpointPath.empty() && loadCheckpoint<Rep>(T))
+        cout << "Resumed from checkpoint " << _checkpointPath << " at T = " << T << endl;
+    else
+        computeNormalizationFactors(_normArea, _normWL, _normBoundary, _normOverlap, 50);
 
-    _tree->pack();
-    double prevCost = computeCost();
+    current.pack();
+    double prevCost = computeCostT<UseArea, HasGhosts, HasFixed>();
     double bestCost = prevCost;
 
     // We must save the "best state". Since Tree holds pointers to _soft_modules,
     // we need to save the Tree structure AND the Block dimensions (because resize changes them).
-    Tree bestTree = *_tree;
+    Rep bestTree = current;
     vector<Block> bestBlocks = _soft_modules; // Save block states (dims)
 
-    while (T > T_min)
+    auto lastCheckpoint = chrono::steady_clock::now();
+    bool stopped = false;
+    while (T > T_min && !stopped)
     {
         for (int i = 0; i < iterations; ++i)
         {
-            Tree backupTree = *_tree;
-            vector<Block> backupBlocks = _soft_modules; // Expensive copy, optimize later if needed
+            if (shouldStop())
+            {
+                stopped = true;
+                break;
+            }
 
-            double oldCost = prevCost;
+            MoveUndo<Rep> undoMove(current);
 
-            // Perturb
-            double r = (double)rand() / RAND_MAX;
+            double oldCost = prevCost;
 
             // Backup offsets
             int backupX = _offsetX;
             int backupY = _offsetY;
 
-            // ==========================================
-            // TUNING: Action Probabilities (Sum = 1.0)
-            // ==========================================
-            double prob_resize = 0.10;       // 10%
-            double prob_rotate = 0.10;       // 10%
-            double prob_swap = 0.35;         // 35% (Global search)
-            double prob_del_ins = 0.35;      // 35% (Topology change)
-            double prob_move_cluster = 0.10; // 10% (Shift entire chip)
-            // ==========================================
-
-            // Calculate cumulative thresholds automatically
-            double t1 = prob_resize;
-            double t2 = t1 + prob_rotate;
-            double t3 = t2 + prob_swap;
-            double t4 = t3 + prob_del_ins;
-            // t5 is effectively 1.0
-
-            if (r < t1)
-                _tree->resizeRandom();
-            else if (r < t2)
-                _tree->rotateRandom();
-            else if (r < t3)
-                _tree->swapRandomNodes();
-            else if (r < t4)
-                _tree->deleteAndInsert();
-            else
-                moveCluster();
+            // Block positions are all rewritten by the next pack(), so only
+            // the shape a resize replaced needs restoring
+            ShapeUndo undoShape = perturbT<Rep>();
 
-            _tree->pack();
-            double newCost = computeCost();
+            current.pack();
+            double newCost = computeCostT<UseArea, HasGhosts, HasFixed>();
             double delta = newCost - oldCost;
 
-            bool accept = (delta < 0) || ((double)rand() / RAND_MAX < exp(-delta / T));
+            bool accept = (delta < 0) || (randUnit(_rng) < exp(-delta / T));
 
             if (accept)
             {
@@ -386,7 +492,7 @@ void Floorplanner::simulatedAnnealing()
                 if (newCost < bestCost)
                 {
                     bestCost = newCost;
-                    bestTree = *_tree;
+                    bestTree = current;
                     bestBlocks = _soft_modules;
                 }
             }
@@ -394,20 +500,238 @@ void Floorplanner::simulatedAnnealing()
             {
                 _offsetX = backupX; // Restore offset if rejected
                 _offsetY = backupY;
-                *_tree = backupTree;
-                _soft_modules = backupBlocks; // Restore dimensions
+                undoMove.restore();
+                undoShape.restore(_soft_modules); // Restore dimensions
             }
         }
-        T *= cooling_rate;
+        if (!stopped)
+            T *= cooling_rate;
+
+        if (!_checkpointPath.empty() &&
+            chrono::duration<double>(chrono::steady_clock::now() - lastCheckpoint).count() >= _checkpointSeconds)
+        {
+            saveCheckpoint(bestTree, bestBlocks, T);
+            lastCheckpoint = chrono::steady_clock::now();
+        }
     }
+    if (stopped)
+        cout << "Annealing stopped early at T = " << T << "; keeping the best packing so far" << endl;
+    if (!_checkpointPath.empty())
+        saveCheckpoint(bestTree, bestBlocks, T);
 
     // Restore Best
-    *_tree = bestTree;
+    current = bestTree;
     _soft_modules = bestBlocks;
-    _tree->pack();
+    current.pack();
     outputWirelength = (size_t)computeWirelength();
 }
 
+void Floorplanner::setDeadline(double seconds)
+{
+    _hasDeadline = true;
+    _deadline = chrono::steady_clock::now() +
+                chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+}
+
+bool Floorplanner::shouldStop() const
+{
+    return _stopRequested || (_hasDeadline && chrono::steady_clock::now() >= _deadline);
+}
+
+// Checkpoint file: temperature, normalization factors, cluster offset, the
+// soft block dimensions (ghosts included) and the B*-tree or sequence pair.
+// Written to a temporary file and renamed over the old one, so it is never
+// half-written.
+template <class Rep>
+bool Floorplanner::saveCheckpoint(const Rep &rep, const vector<Block> &blocks, double T) const
+{
+    const string tmpPath = _checkpointPath + ".tmp";
+    {
+        fstream out(tmpPath, ios::out);
+        if (!out)
+            return false;
+        out << setprecision(17);
+        out << "FPCHECKPOINT 1\n";
+        out << "T " << T << "\n";
+        out << "NORM " << _normArea << " " << _normWL << " " << _normBoundary << " " << _normOverlap << "\n";
+        out << "OFFSET " << _offsetX << " " << _offsetY << "\n";
+        out << "BLOCKS " << blocks.size() << "\n";
+        for (const auto &b : blocks)
+            out << b.getWidth() << " " << b.getHeight() << "\n";
+        out << Rep::checkpointTag() << " ";
+        rep.save(out);
+        if (!out.flush())
+            return false;
+    }
+    return rename(tmpPath.c_str(), _checkpointPath.c_str()) == 0;
+}
+
+// Load a checkpoint written by saveCheckpoint(). Nothing is changed unless the
+// whole file parses and fits the current problem.
+template <class Rep>
+bool Floorplanner::loadCheckpoint(double &T)
+{
+    fstream in(_checkpointPath, ios::in);
+    if (!in)
+        return false;
+
+    string key;
+    int version = 0;
+    double t, nArea, nWL, nBound, nOverlap;
+    int offX, offY;
+    size_t numBlocks;
+    if (!(in >> key >> version) || key != "FPCHECKPOINT" || version != 1 ||
+        !(in >> key >> t) || key != "T" ||
+        !(in >> key >> nArea >> nWL >> nBound >> nOverlap) || key != "NORM" ||
+        !(in >> key >> offX >> offY) || key != "OFFSET" ||
+        !(in >> key >> numBlocks) || key != "BLOCKS" || numBlocks != _soft_modules.size())
+    {
+        cerr << "Warning: ignoring checkpoint " << _checkpointPath << " (does not match this input)" << endl;
+        return false;
+    }
+
+    vector<size_t> w(numBlocks), h(numBlocks);
+    for (size_t i = 0; i < numBlocks; ++i)
+    {
+        if (!(in >> w[i] >> h[i]) || (!_soft_modules[i].isGhost() && w[i] * h[i] < _soft_modules[i].getMinArea()))
+        {
+            cerr << "Warning: ignoring checkpoint " << _checkpointPath << " (does not match this input)" << endl;
+            return false;
+        }
+    }
+    if (!(in >> key) || key != Rep::checkpointTag() || !rep<Rep>().load(in))
+    {
+        cerr << "Warning: ignoring checkpoint " << _checkpointPath << " (bad " << Rep::checkpointTag() << ")" << endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < numBlocks; ++i)
+    {
+        _soft_modules[i].setWidth(w[i]);
+        _soft_modules[i].setHeight(h[i]);
+    }
+    T = t;
+    _normArea = nArea;
+    _normWL = nWL;
+    _normBoundary = nBound;
+    _normOverlap = nOverlap;
+    _offsetX = offX;
+    _offsetY = offY;
+    return true;
+}
+
+// One random move on the current packing (tree shape, block shape or offset)
+void Floorplanner::perturb()
+{
+    if (_seqPair)
+        perturbT<SeqPair>();
+    else
+        perturbT<Tree>();
+}
+
+template <class Rep>
+ShapeUndo Floorplanner::perturbT()
+{
+    double r = randUnit(_rng);
+
+    // ==========================================
+    // TUNING: Action Probabilities (Sum = 1.0)
+    // ==========================================
+    double prob_resize = 0.10;       // 10%
+    double prob_rotate = 0.10;       // 10%
+    double prob_swap = 0.35;         // 35% (Global search)
+    double prob_del_ins = 0.35;      // 35% (Topology change)
+    double prob_move_cluster = 0.10; // 10% (Shift entire chip)
+    // ==========================================
+
+    // Calculate cumulative thresholds automatically
+    double t1 = prob_resize;
+    double t2 = t1 + prob_rotate;
+    double t3 = t2 + prob_swap;
+    double t4 = t3 + prob_del_ins;
+    // t5 is effectively 1.0
+
+    // Only a resize touches the blocks; the other moves change the
+    // representation or the offset
+    if (r < t1)
+        return rep<Rep>().resizeRandom();
+    if (r < t2)
+        rep<Rep>().rotateRandom();
+    else if (r < t3)
+        rep<Rep>().swapRandomNodes();
+    else if (r < t4)
+        rep<Rep>().deleteAndInsert();
+    else
+        moveCluster();
+    return ShapeUndo();
+}
+
+// Short Metropolis walk at a fixed temperature, starting from the current
+// packing. Unlike simulatedAnnealing() it keeps the state it ends in rather
+// than the best one seen, so the caller can judge the walk by its own measure
+// (the co-optimisation driver uses post-refinement HPWL) and roll it back.
+// Normalization factors from the preceding simulatedAnnealing() are reused.
+void Floorplanner::annealBurst(double T, int moves)
+{
+    if (_seqPair)
+        annealBurstFor<SeqPair>(T, moves);
+    else
+        annealBurstFor<Tree>(T, moves);
+}
+
+template <class Rep>
+void Floorplanner::annealBurstFor(double T, int moves)
+{
+    switch (costConfig())
+    {
+    case 0: annealBurstT<Rep, false, false, false>(T, moves); break;
+    case 1: annealBurstT<Rep, false, false, true>(T, moves); break;
+    case 2: annealBurstT<Rep, false, true, false>(T, moves); break;
+    case 3: annealBurstT<Rep, false, true, true>(T, moves); break;
+    case 4: annealBurstT<Rep, true, false, false>(T, moves); break;
+    case 5: annealBurstT<Rep, true, false, true>(T, moves); break;
+    case 6: annealBurstT<Rep, true, true, false>(T, moves); break;
+    default: annealBurstT<Rep, true, true, true>(T, moves); break;
+    }
+}
+
+template <class Rep, bool UseArea, bool HasGhosts, bool HasFixed>
+void Floorplanner::annealBurstT(double T, int moves)
+{
+    Rep &current = rep<Rep>();
+    current.pack();
+    double prevCost = computeCostT<UseArea, HasGhosts, HasFixed>();
+
+    for (int i = 0; i < moves; ++i)
+    {
+        MoveUndo<Rep> undoMove(current);
+        int backupX = _offsetX;
+        int backupY = _offsetY;
+
+        ShapeUndo undoShape = perturbT<Rep>();
+
+        current.pack();
+        double newCost = computeCostT<UseArea, HasGhosts, HasFixed>();
+        double delta = newCost - prevCost;
+
+        bool accept = (delta < 0) || (randUnit(_rng) < exp(-delta / T));
+
+        if (accept)
+        {
+            prevCost = newCost;
+        }
+        else
+        {
+            _offsetX = backupX;
+            _offsetY = backupY;
+            undoMove.restore();
+            undoShape.restore(_soft_modules);
+        }
+    }
+
+    current.pack();
+}
+
 // // 4. Output Logic (ICCAD Format)
 // void Floorplanner::outputResults(fstream &outputFile, double runtime)
 // {
@@ -476,7 +800,7 @@ void Floorplanner::simulatedAnnealing()
 void Floorplanner::outputResults(fstream &outputFile, double runtime)
 {
     // 1. Ensure the tree is packed one last time
-    _tree->pack();
+    packCurrent();
 
     // 2. Output Header
     double finalHPWL = computeWirelength();
@@ -524,8 +848,8 @@ void Floorplanner::moveCluster()
     // or drift it slightly.
 
     // Random drift: -100 to +100 units
-    int driftX = (rand() % 200) - 100;
-    int driftY = (rand() % 200) - 100;
+    int driftX = randIndex(_rng, 200) - 100;
+    int driftY = randIndex(_rng, 200) - 100;
 
     _offsetX += driftX;
     _offsetY += driftY;
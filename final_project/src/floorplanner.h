@@ -6,9 +6,13 @@
 #include <string>
 #include <fstream>
 #include <unordered_map>
+#include <chrono>
+#include <csignal>
+#include <random>
 #include "module.h"
 #include "node.h"
 #include "tree.h"
+#include "seqpair.h"
 
 using namespace std;
 
@@ -46,6 +50,14 @@ public:
     unordered_map<string, Terminal *> _name2Terminal;
 
     Tree *_tree;
+    SeqPair *_seqPair = nullptr; // set by useSequencePair(); annealed instead of _tree
+
+    // All random draws of this instance (moves, acceptance) come from here;
+    // seed it before floorplan(). One per replica keeps threads independent.
+    mt19937 _rng;
+
+    // Anneal a sequence pair instead of the B*-tree (call before floorplan())
+    void useSequencePair();
 
     // Parsing
     void parseInput(fstream &inputFile);
@@ -56,6 +68,8 @@ public:
 
     // Optimization & Cost
     void simulatedAnnealing(); // Added this!
+    void perturb(); // one random SA move
+    void annealBurst(double T, int moves); // fixed-T walk from the current state
 
     double computeWirelength();
     double computeArea(); // Added this!
@@ -72,7 +86,52 @@ public:
 
     void moveCluster();
 
+    // Anytime control. simulatedAnnealing() stops at the deadline or once
+    // _stopRequested is set (from a SIGTERM/SIGINT handler) and leaves the
+    // best packing found so far in place, ready for outputResults().
+    static volatile sig_atomic_t _stopRequested;
+    void setDeadline(double seconds); // from now
+    bool shouldStop() const;
+
+    // Optional checkpoint: the best packing and the annealing temperature are
+    // saved every _checkpointSeconds; simulatedAnnealing() resumes from the
+    // file if it exists and matches this problem.
+    string _checkpointPath;
+    double _checkpointSeconds = 30.0;
+    template <class Rep>
+    bool saveCheckpoint(const Rep &rep, const vector<Block> &blocks, double T) const;
+    template <class Rep>
+    bool loadCheckpoint(double &T);
+
 private:
+    // Cost terms that are dead for a whole run are compiled out: UseArea
+    // (alpha != 0), HasGhosts (ghost blocks were injected), HasFixed (any
+    // fixed module). The annealing loops are instantiated per combination and
+    // picked once per call through costConfig().
+    int costConfig() const;
+    template <bool UseArea, bool HasGhosts, bool HasFixed>
+    double computeCostT();
+    template <bool HasGhosts>
+    double computeFixedOverlapPenaltyT();
+    template <class Rep, bool UseArea, bool HasGhosts, bool HasFixed>
+    void simulatedAnnealingT();
+    template <class Rep, bool UseArea, bool HasGhosts, bool HasFixed>
+    void annealBurstT(double T, int moves);
+
+    // The loops are also instantiated per representation (Tree or SeqPair)
+    template <class Rep>
+    Rep &rep();
+    template <class Rep>
+    void simulatedAnnealingFor();
+    template <class Rep>
+    void annealBurstFor(double T, int moves);
+    template <class Rep>
+    ShapeUndo perturbT(); // what to undo on the blocks if the move is rejected
+    void packCurrent();
+
+    bool _hasDeadline = false;
+    chrono::steady_clock::time_point _deadline;
+
     size_t outputWirelength;
     double _normWL = 1.0;
     double _normArea = 1.0;
@@ -0,0 +1,250 @@
+// gen_case.cpp
+// Synthetic ICCAD 2023 Problem D case generator, for scaling runs beyond the
+// contest cases (the largest of which has a few dozen modules).
+//
+// Soft module areas are log-normal around a median. The chip is sized so that
+// the fixed macros cover a given fraction of it and the soft modules fill a
+// given fraction of what is left. Fixed macros are dropped at random
+// non-overlapping positions. Connectivity follows Rent's rule: the modules
+// (soft and fixed, shuffled) are bisected recursively and every split of a
+// block of k modules gets t * (2 * (k/2)^p - k^p) edges across it, so a block
+// of k modules ends up with about t * k^p external connections.
+//
+// The same seed always gives the same file.
+//
+// Build:
+//   make gen
+// Run:
+//   ./bin/gen_case <numSoft> <output.txt> [--seed=1] [--area=40000] [--sigma=0.6]
+//                  [--fixed=0.1] [--nfixed=numSoft/20] [--util=0.7] [--aspect=1.0]
+//                  [--rent=0.6] [--terms=3.0] [--wmin=50] [--wmax=500]
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+struct GenOptions
+{
+    int numSoft = 0;
+    unsigned int seed = 1;
+    double areaMedian = 40000.0; // median soft module area
+    double areaSigma = 0.6;      // log-normal sigma of soft areas
+    double fixedFrac = 0.1;      // chip area covered by fixed macros
+    int numFixed = -1;           // -1: numSoft / 20 (at least 1 when fixedFrac > 0)
+    double util = 0.7;           // soft area / chip area not taken by fixed macros
+    double aspect = 1.0;         // chip width / height
+    double rentP = 0.6;          // Rent exponent
+    double rentT = 3.0;          // terminals of a single module
+    int wMin = 50, wMax = 500;   // connection weight range
+};
+
+struct FixedRect
+{
+    long long x, y, w, h;
+};
+
+static bool parseOption(const string &arg, GenOptions &opt)
+{
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == string::npos)
+        return false;
+    const string key = arg.substr(2, eq - 2);
+    const char *val = arg.c_str() + eq + 1;
+
+    if (key == "seed")
+        opt.seed = (unsigned int)strtoul(val, nullptr, 10);
+    else if (key == "area")
+        opt.areaMedian = atof(val);
+    else if (key == "sigma")
+        opt.areaSigma = atof(val);
+    else if (key == "fixed")
+        opt.fixedFrac = atof(val);
+    else if (key == "nfixed")
+        opt.numFixed = atoi(val);
+    else if (key == "util")
+        opt.util = atof(val);
+    else if (key == "aspect")
+        opt.aspect = atof(val);
+    else if (key == "rent")
+        opt.rentP = atof(val);
+    else if (key == "terms")
+        opt.rentT = atof(val);
+    else if (key == "wmin")
+        opt.wMin = atoi(val);
+    else if (key == "wmax")
+        opt.wMax = atoi(val);
+    else
+        return false;
+    return true;
+}
+
+static bool overlaps(const FixedRect &a, const FixedRect &b)
+{
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+// Drop numFixed macros of about totalArea / numFixed each at random positions.
+// A macro that does not fit after a number of tries is shrunk and retried, so
+// very dense settings still terminate (with less fixed area than asked for).
+static vector<FixedRect> placeFixed(mt19937 &rng, long long W, long long H, int numFixed, double totalArea)
+{
+    vector<FixedRect> fixed;
+    if (numFixed <= 0 || totalArea <= 0)
+        return fixed;
+
+    uniform_real_distribution<double> aspectDist(0.5, 2.0);
+    double area = totalArea / numFixed;
+    for (int k = 0; k < numFixed; ++k)
+    {
+        bool placed = false;
+        for (double a = area; !placed && a >= 1.0; a *= 0.5)
+        {
+            for (int attempt = 0; attempt < 200 && !placed; ++attempt)
+            {
+                double r = aspectDist(rng);
+                FixedRect f;
+                f.w = max(1LL, min(W, (long long)llround(sqrt(a * r))));
+                f.h = max(1LL, min(H, (long long)llround(a / f.w)));
+                f.x = uniform_int_distribution<long long>(0, W - f.w)(rng);
+                f.y = uniform_int_distribution<long long>(0, H - f.h)(rng);
+
+                placed = true;
+                for (const FixedRect &g : fixed)
+                    if (overlaps(f, g))
+                    {
+                        placed = false;
+                        break;
+                    }
+                if (placed)
+                    fixed.push_back(f);
+            }
+        }
+    }
+    return fixed;
+}
+
+// Rent-style edges over order[lo, hi): recurse into both halves, then connect
+// them with the number of edges the rule leaves for this split.
+static void rentEdges(mt19937 &rng, const GenOptions &opt, const vector<int> &order, int lo, int hi,
+                      map<pair<int, int>, int> &edges)
+{
+    const int k = hi - lo;
+    if (k < 2)
+        return;
+    const int mid = lo + k / 2;
+    rentEdges(rng, opt, order, lo, mid, edges);
+    rentEdges(rng, opt, order, mid, hi, edges);
+
+    const double half = 0.5 * k;
+    const double cut = opt.rentT * (2.0 * pow(half, opt.rentP) - pow((double)k, opt.rentP));
+    const int count = max(1, (int)llround(cut));
+
+    uniform_int_distribution<int> left(lo, mid - 1), right(mid, hi - 1);
+    uniform_int_distribution<int> weight(opt.wMin, opt.wMax);
+    for (int e = 0; e < count; ++e)
+    {
+        int a = order[left(rng)];
+        int b = order[right(rng)];
+        if (a > b)
+            swap(a, b);
+        // a pair drawn again gets heavier, but stays within [wMin, wMax]
+        int &w = edges[make_pair(a, b)];
+        w = min(opt.wMax, w + weight(rng));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        cerr << "Usage: " << argv[0] << " <numSoft> <output file> [--seed=N] [--area=A] [--sigma=S]"
+             << " [--fixed=F] [--nfixed=N] [--util=U] [--aspect=R] [--rent=P] [--terms=T]"
+             << " [--wmin=W] [--wmax=W]" << endl;
+        return 1;
+    }
+
+    GenOptions opt;
+    opt.numSoft = atoi(argv[1]);
+    const string outputPath = argv[2];
+    for (int i = 3; i < argc; ++i)
+    {
+        if (!parseOption(argv[i], opt))
+        {
+            cerr << "Unknown option: " << argv[i] << endl;
+            return 1;
+        }
+    }
+    if (opt.numSoft < 1 || opt.areaMedian < 1 || opt.util <= 0 || opt.util > 1 ||
+        opt.fixedFrac < 0 || opt.fixedFrac >= 1 || opt.aspect <= 0 ||
+        opt.wMin < 1 || opt.wMax < opt.wMin)
+    {
+        cerr << "Invalid options" << endl;
+        return 1;
+    }
+    if (opt.numFixed < 0)
+        opt.numFixed = (opt.fixedFrac > 0) ? max(1, opt.numSoft / 20) : 0;
+
+    mt19937 rng(opt.seed);
+
+    // Soft areas
+    lognormal_distribution<double> areaDist(log(opt.areaMedian), opt.areaSigma);
+    vector<long long> softArea(opt.numSoft);
+    double softTotal = 0;
+    for (int i = 0; i < opt.numSoft; ++i)
+    {
+        double a = min(max(areaDist(rng), opt.areaMedian / 10), opt.areaMedian * 10);
+        softArea[i] = max(1LL, llround(a));
+        softTotal += softArea[i];
+    }
+
+    // Chip
+    const double chipArea = softTotal / (opt.util * (1.0 - opt.fixedFrac));
+    const long long W = max(1LL, llround(sqrt(chipArea * opt.aspect)));
+    const long long H = max(1LL, llround(chipArea / W));
+
+    vector<FixedRect> fixed = placeFixed(rng, W, H, opt.numFixed, opt.fixedFrac * (double)W * H);
+
+    // Connectivity over soft ids [0, numSoft) and fixed ids after them
+    const int total = opt.numSoft + (int)fixed.size();
+    vector<int> order(total);
+    for (int i = 0; i < total; ++i)
+        order[i] = i;
+    shuffle(order.begin(), order.end(), rng);
+    map<pair<int, int>, int> edges;
+    rentEdges(rng, opt, order, 0, total, edges);
+
+    auto name = [&](int id)
+    {
+        return (id < opt.numSoft) ? "M" + to_string(id) : "F" + to_string(id - opt.numSoft);
+    };
+
+    ofstream out(outputPath);
+    if (!out)
+    {
+        cerr << "Cannot open output file: " << outputPath << endl;
+        return 1;
+    }
+    out << "CHIP " << W << " " << H << "\n";
+    out << "SOFTMODULE " << opt.numSoft << "\n";
+    for (int i = 0; i < opt.numSoft; ++i)
+        out << name(i) << " " << softArea[i] << "\n";
+    out << "FIXEDMODULE " << fixed.size() << "\n";
+    for (size_t k = 0; k < fixed.size(); ++k)
+        out << name(opt.numSoft + (int)k) << " " << fixed[k].x << " " << fixed[k].y << " "
+            << fixed[k].w << " " << fixed[k].h << "\n";
+    out << "CONNECTION " << edges.size() << "\n";
+    for (const auto &kv : edges)
+        out << name(kv.first.first) << " " << name(kv.first.second) << " " << kv.second << "\n";
+
+    cout << "Chip " << W << " x " << H << ", " << opt.numSoft << " soft, " << fixed.size()
+         << " fixed, " << edges.size() << " connections" << endl;
+    return 0;
+}
@@ -6,6 +6,9 @@
 #include <ctime>
 #include <cstdlib>
 #include <chrono>
+#include <cstdio>
+#include <csignal>
+#include <string>
 
 #include "floorplanner.h"
 
@@ -17,51 +20,106 @@ using namespace std;
 // specify file name:
 // python3 visualize.py input_case1.txt output_case1.txt -o my_floorplan.png
 
+// Options (anywhere on the command line):
+//   --deadline=<seconds>  stop annealing this long after start and write the best so far
+//   --checkpoint=<file>   save the search state periodically; resume from it if present
+//   --rep=btree|sp        anneal a B*-tree (default) or a sequence pair
+// SIGTERM / SIGINT stop the annealing the same way as the deadline.
+
+static void onStopSignal(int sig)
+{
+    Floorplanner::_stopRequested = 1;
+    signal(sig, SIG_DFL); // a second signal terminates as usual
+}
+
+// Write to <path>.tmp and rename it over path, so the result file is either
+// the old one or the complete new one
+static bool writeResultsAtomically(Floorplanner *fp, const string &path, double runtime)
+{
+    const string tmpPath = path + ".tmp";
+    {
+        fstream output(tmpPath, ios::out);
+        if (!output)
+            return false;
+        fp->outputResults(output, runtime);
+        if (!output.flush())
+            return false;
+    }
+    return rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
 int main(int argc, char **argv)
 {
-    srand(static_cast<unsigned int>(time(0)));
-    fstream input_file, output;
+    fstream input_file;
+    string outputPath;
     double alpha = 0.5; // Default alpha
+    double deadline = 0; // seconds, 0 = none
+    string checkpointPath;
+    string representation = "btree";
+
+    vector<string> args;
+    for (int i = 1; i < argc; ++i)
+    {
+        string a = argv[i];
+        if (a.compare(0, 11, "--deadline=") == 0)
+            deadline = stod(a.substr(11));
+        else if (a.compare(0, 13, "--checkpoint=") == 0)
+            checkpointPath = a.substr(13);
+        else if (a.compare(0, 6, "--rep=") == 0)
+            representation = a.substr(6);
+        else
+            args.push_back(a);
+    }
 
     // ICCAD Format: ./fp [input_file] [output_file]
     // Or your Makefile format: ./fp [alpha] [input] [output] (Let's support your Makefile format)
 
-    if (argc == 4)
+    if (args.size() == 3)
     {
         cout << "Makefile Format Detected." << endl;
         // format: ./fp <alpha> <input> <output>
-        alpha = stod(argv[1]);
-        input_file.open(argv[2], ios::in);
-        output.open(argv[3], ios::out);
+        alpha = stod(args[0]);
+        input_file.open(args[1], ios::in);
+        outputPath = args[2];
 
         if (!input_file)
         {
-            cerr << "Cannot open input file: " << argv[2] << endl;
-            exit(1);
-        }
-        if (!output)
-        {
-            cerr << "Cannot open output file: " << argv[3] << endl;
+            cerr << "Cannot open input file: " << args[1] << endl;
             exit(1);
         }
     }
     // ICCAD Contest format often uses: ./binary input output
-    else if (argc == 3)
+    else if (args.size() == 2)
     {
         // cout << "ICCAD Format Detected." << endl;
-        input_file.open(argv[1], ios::in);
-        output.open(argv[2], ios::out);
+        input_file.open(args[0], ios::in);
+        outputPath = args[1];
         alpha = 0; // Default if not provided
     }
     else
     {
-        cerr << "Usage: ./Floorplanner <alpha> <input file> <output file>" << endl;
+        cerr << "Usage: ./Floorplanner [alpha] <input file> <output file> [--deadline=seconds] [--checkpoint=file]"
+             << " [--rep=btree|sp]" << endl;
         exit(1);
     }
+    if (representation != "btree" && representation != "sp")
+    {
+        cerr << "Unknown representation: " << representation << " (btree or sp)" << endl;
+        exit(1);
+    }
+
+    signal(SIGTERM, onStopSignal);
+    signal(SIGINT, onStopSignal);
 
     // New Constructor: Single input file
     Floorplanner *fp = new Floorplanner(input_file, alpha);
+    fp->_rng.seed(static_cast<unsigned int>(time(0)));
     // cout << "Floorplanner initialized with alpha = " << alpha << endl;
+    fp->_checkpointPath = checkpointPath;
+    if (representation == "sp")
+        fp->useSequencePair();
+    if (deadline > 0)
+        fp->setDeadline(deadline); // parsing is short next to annealing
 
     // Start timing
     auto start_time = chrono::high_resolution_clock::now();
@@ -75,7 +133,11 @@ int main(int argc, char **argv)
     cout << "Time taken: " << duration.count() * 0.001 << " s" << endl;
 
     // Output results
-    fp->outputResults(output, duration.count() * 0.001);
+    if (!writeResultsAtomically(fp, outputPath, duration.count() * 0.001))
+    {
+        cerr << "Cannot write output file: " << outputPath << endl;
+        exit(1);
+    }
 
     return 0;
 }
\ No newline at end of file
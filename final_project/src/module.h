@@ -184,6 +184,22 @@ private:
     Node *_node;
 };
 
+// The shape a resize move replaced, so a rejected move can put back just that
+// block instead of a copy of the whole block array
+struct ShapeUndo
+{
+    int index = -1; // no block reshaped
+    size_t w = 0, h = 0;
+
+    void restore(vector<Block> &blocks) const
+    {
+        if (index < 0)
+            return;
+        blocks[index].setWidth(w);
+        blocks[index].setHeight(h);
+    }
+};
+
 class Net
 {
 public:
@@ -0,0 +1,318 @@
+// pipeline.cpp
+// Both stages in one process: stage-1 floorplanner replicas run on worker
+// threads, and each replica's packed placement is handed to the refine2 refiner
+// in memory as soon as that replica finishes. No stage-1 text file is written or
+// re-parsed. The best refined replica is written out.
+//
+// With a co-optimisation budget, each replica then alternates short annealing
+// bursts with refinement for that many seconds: a burst is kept or rolled back
+// by Metropolis on the refined HPWL, so the packing drifts toward shapes that
+// refine well rather than ones that merely score well before stage 2.
+//
+// Build:
+//   make pipeline
+// Run:
+//   ./bin/pipeline <input.txt> <result.out> [replicas] [threads] [cooptSeconds]
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <ctime>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <map>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "floorplanner.h"
+#include "refiner.h"
+
+using namespace std;
+
+// Stage-2 tuning (same defaults as the standalone refiner)
+static const int refinePasses = 6;
+static const int refineMaxMoves = 2000;
+
+// Co-optimisation tuning
+static const double burstTemp = 1e-2;       // stage-1 cost temperature inside a burst
+static const double burstMovesPerMod = 0.1; // burst length per soft module
+static const double coTempInit = 0.001;     // refined-HPWL temperature, relative to the start HPWL
+static const double coCooling = 0.97;       // per burst
+
+struct ReplicaResult
+{
+    bool ok = false;
+    double hpwl = 0.0;
+    double stage1Hpwl = 0.0;
+    string error;
+    int bursts = 0, accepted = 0; // co-optimisation stats
+    vector<refine2::Rect> stage1;
+    vector<refine2::Rect> rects;
+};
+
+// Problem in refine2 ids, taken from a parsed Floorplanner. Soft ids follow
+// _soft_modules with ghosts skipped (ghosts are appended after the real ones),
+// fixed ids follow _fixed_modules. Every replica parses the same file, so the
+// tables built from any one of them are valid for all.
+static refine2::Problem buildProblem(Floorplanner &fp)
+{
+    refine2::Problem pb;
+    pb.W = (int)fp._chipWidth;
+    pb.H = (int)fp._chipHeight;
+
+    unordered_map<const Terminal *, int> id;
+    for (const Block &b : fp._soft_modules)
+    {
+        if (b.isGhost())
+            continue;
+        refine2::SoftSpec s;
+        s.name = b.getName();
+        s.minArea = (int)b.getMinArea();
+        id[&b] = (int)pb.soft.size();
+        pb.soft.push_back(s);
+    }
+    for (const Block &b : fp._fixed_modules)
+    {
+        refine2::FixedMod f;
+        f.name = b.getName();
+        f.r.x1 = (int)b.getX1();
+        f.r.y1 = (int)b.getY1();
+        f.r.x2 = (int)b.getX2();
+        f.r.y2 = (int)b.getY2();
+        id[&b] = (int)(pb.soft.size() + pb.fixed.size());
+        pb.fixed.push_back(f);
+    }
+
+    // _net_array holds one 2-pin net per unit of connection weight; fold them
+    // back into weighted edges
+    map<pair<int, int>, int> weight;
+    for (Net &net : fp._net_array)
+    {
+        const vector<Terminal *> terms = net.getTermList();
+        if (terms.size() != 2)
+            continue;
+        auto ia = id.find(terms[0]);
+        auto ib = id.find(terms[1]);
+        if (ia == id.end() || ib == id.end())
+            continue;
+        weight[make_pair(ia->second, ib->second)]++;
+    }
+    for (const auto &kv : weight)
+    {
+        refine2::Connection c;
+        c.a = kv.first.first;
+        c.b = kv.first.second;
+        c.w = kv.second;
+        pb.conns.push_back(c);
+    }
+    refine2::build_adjacency(pb);
+    return pb;
+}
+
+// Packed stage-1 soft rectangles (ghosts dropped, cluster offset applied)
+static vector<refine2::Rect> stage1Rects(Floorplanner &fp)
+{
+    fp._tree->pack();
+    vector<refine2::Rect> rects;
+    for (const Block &b : fp._soft_modules)
+    {
+        if (b.isGhost())
+            continue;
+        refine2::Rect r;
+        r.x1 = (int)b.getX1() + fp._offsetX;
+        r.y1 = (int)b.getY1() + fp._offsetY;
+        r.x2 = (int)b.getX2() + fp._offsetX;
+        r.y2 = (int)b.getY2() + fp._offsetY;
+        rects.push_back(r);
+    }
+    return rects;
+}
+
+// Alternate annealBurst() and refine() on one replica until the deadline. The
+// accepted state is rolled back the same way simulatedAnnealing() does it
+// (Tree / block / offset copies). Until some burst refines legally there is
+// nothing to roll back to, so illegal bursts are kept and the replica walks on.
+// res keeps the best refined placement seen.
+static void coOptimize(Floorplanner &fp, const refine2::Problem &pb, double seconds, ReplicaResult &res)
+{
+    const auto deadline = chrono::steady_clock::now() + chrono::duration<double>(seconds);
+    const int moves = max(1, (int)(burstMovesPerMod * fp._soft_modules.size()));
+
+    bool haveCur = res.ok;
+    double cur = res.hpwl;
+    double T = coTempInit * (res.ok ? res.hpwl : 1.0);
+    int bursts = 0, accepted = 0;
+
+    while (chrono::steady_clock::now() < deadline)
+    {
+        Tree backupTree = *fp._tree;
+        vector<Block> backupBlocks = fp._soft_modules;
+        int backupX = fp._offsetX;
+        int backupY = fp._offsetY;
+
+        fp.annealBurst(burstTemp, moves);
+        ++bursts;
+
+        vector<refine2::Rect> rects = stage1Rects(fp);
+        bool legal = true;
+        double h = 0.0;
+        try
+        {
+            h = refine2::refine(pb, rects, refinePasses, refineMaxMoves);
+        }
+        catch (const exception &)
+        {
+            legal = false;
+        }
+
+        bool accept = false;
+        if (legal && !haveCur)
+        {
+            accept = true;
+            T = coTempInit * h; // first legal state fixes the scale
+        }
+        else if (legal)
+            accept = (h < cur) || (randUnit(fp._rng) < exp(-(h - cur) / T));
+
+        if (accept)
+        {
+            ++accepted;
+            haveCur = true;
+            cur = h;
+            if (!res.ok || h < res.hpwl)
+            {
+                res.ok = true;
+                res.hpwl = h;
+                res.rects = rects;
+            }
+        }
+        else if (haveCur)
+        {
+            fp._offsetX = backupX;
+            fp._offsetY = backupY;
+            *fp._tree = backupTree;
+            fp._soft_modules = backupBlocks;
+        }
+        T *= coCooling;
+    }
+    fp._tree->pack();
+
+    res.bursts = bursts;
+    res.accepted = accepted;
+}
+
+int main(int argc, char **argv)
+{
+    // replica r anneals with seed + r
+    const unsigned int seed = static_cast<unsigned int>(time(0));
+
+    if (argc < 3)
+    {
+        cerr << "Usage: " << argv[0] << " <input file> <output file> [replicas] [threads] [cooptSeconds]" << endl;
+        return 1;
+    }
+    const string inputPath = argv[1];
+    const string outputPath = argv[2];
+    const int replicas = (argc > 3) ? max(1, atoi(argv[3])) : 1;
+    int threads = (argc > 4) ? max(1, atoi(argv[4])) : (int)thread::hardware_concurrency();
+    threads = max(1, min(threads, replicas));
+    const double cooptSeconds = (argc > 5) ? max(0.0, atof(argv[5])) : 0.0;
+
+    auto start_time = chrono::high_resolution_clock::now();
+
+    refine2::Problem pb;
+    once_flag pbOnce;
+    vector<ReplicaResult> results(replicas);
+    atomic<int> next(0);
+    mutex logMutex;
+
+    auto worker = [&]()
+    {
+        for (int r = next++; r < replicas; r = next++)
+        {
+            fstream input_file(inputPath, ios::in);
+            if (!input_file)
+            {
+                results[r].error = "Cannot open input file: " + inputPath;
+                continue;
+            }
+            Floorplanner *fp = new Floorplanner(input_file, 0);
+            fp->_rng.seed(seed + r);
+            fp->floorplan();
+
+            call_once(pbOnce, [&]()
+                      { pb = buildProblem(*fp); });
+
+            // Stage 2 right away; other replicas may still be annealing
+            ReplicaResult &res = results[r];
+            res.stage1 = stage1Rects(*fp);
+            res.stage1Hpwl = refine2::total_hpwl(pb, res.stage1);
+            res.rects = res.stage1;
+            try
+            {
+                res.hpwl = refine2::refine(pb, res.rects, refinePasses, refineMaxMoves);
+                res.ok = true;
+            }
+            catch (const exception &e)
+            {
+                res.error = e.what();
+            }
+            const double firstHpwl = res.hpwl;
+            const bool firstOk = res.ok;
+
+            if (cooptSeconds > 0)
+                coOptimize(*fp, pb, cooptSeconds, res);
+            delete fp;
+
+            lock_guard<mutex> lk(logMutex);
+            cout << fixed;
+            if (firstOk)
+                cout << "Replica " << r << ": HPWL " << firstHpwl;
+            else
+                cout << "Replica " << r << ": rejected (" << res.error << ")";
+            if (cooptSeconds > 0)
+                cout << " -> " << (res.ok ? res.hpwl : 0.0) << " after co-opt ("
+                     << res.accepted << "/" << res.bursts << " bursts kept)";
+            cout << endl;
+        }
+    };
+
+    vector<thread> pool;
+    for (int t = 0; t < threads; ++t)
+        pool.emplace_back(worker);
+    for (thread &t : pool)
+        t.join();
+
+    int best = -1;
+    for (int r = 0; r < replicas; ++r)
+        if (results[r].ok && (best < 0 || results[r].hpwl < results[best].hpwl))
+            best = r;
+
+    auto end_time = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::milliseconds>(end_time - start_time);
+    cout << "Time taken: " << duration.count() * 0.001 << " s" << endl;
+
+    if (best < 0)
+    {
+        // nothing the refiner accepts; keep what stage 1 alone would have written
+        int fallback = -1;
+        for (int r = 0; r < replicas; ++r)
+            if (!results[r].stage1.empty() && (fallback < 0 || results[r].stage1Hpwl < results[fallback].stage1Hpwl))
+                fallback = r;
+        if (fallback < 0)
+        {
+            cerr << "ERROR: " << results[0].error << endl;
+            return 2;
+        }
+        cerr << "Warning: no replica could be refined; writing stage-1 placement of replica " << fallback << endl;
+        refine2::write_output(outputPath, pb, results[fallback].stage1);
+        return 0;
+    }
+    cout << "Best replica " << best << ": HPWL " << fixed << results[best].hpwl << endl;
+    refine2::write_output(outputPath, pb, results[best].rects);
+    return 0;
+}
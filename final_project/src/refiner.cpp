@@ -9,6 +9,8 @@
 //   - structured bindings (auto [a,b])
 // so it compiles cleanly even if your toolchain is picky.
 //
+// The types and entry points used by other translation units live in refiner.h.
+//
 // Build (standalone):
 //   g++ -O2 -std=c++17 refiner.cpp -DREFINE_STANDALONE -o refiner
 // Run:
@@ -26,6 +28,7 @@
 #include <iostream>
 #include <limits>
 #include <numeric>
+#include <queue>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -33,18 +36,10 @@
 #include <utility>
 #include <vector>
 
+#include "refiner.h"
+
 namespace refine2
 {
-
-    static const int16_t EMPTY = -1;
-    static const int16_t FIXED = -2;
-
-    struct Rect
-    {
-        int x1, y1, x2, y2; // half-open: [x1,x2) x [y1,y2)
-        Rect() : x1(0), y1(0), x2(0), y2(0) {}
-    };
-
     static inline int rect_w(const Rect &r) { return r.x2 - r.x1; }
     static inline int rect_h(const Rect &r) { return r.y2 - r.y1; }
     static inline double rect_cx(const Rect &r) { return 0.5 * (double(r.x1) + double(r.x2)); }
@@ -60,36 +55,6 @@ namespace refine2
         return (ar >= 0.5 && ar <= 2.0);
     }
 
-    struct SoftSpec
-    {
-        std::string name;
-        int minArea;
-        SoftSpec() : name(), minArea(0) {}
-    };
-
-    struct FixedMod
-    {
-        std::string name;
-        Rect r;
-    };
-
-    struct Connection
-    {
-        int a, b;
-        int w;
-        Connection() : a(-1), b(-1), w(0) {}
-    };
-
-    struct Problem
-    {
-        int W, H;
-        std::vector<SoftSpec> soft;
-        std::vector<FixedMod> fixed;
-        std::vector<Connection> conns;
-        std::vector<std::vector<std::pair<int, int>>> adj; // adj[i] = (neighbor, weight)
-        Problem() : W(0), H(0) {}
-    };
-
     struct Stage1Placement
     {
         std::vector<Rect> softRects; // MBR-based rectangles for each soft module
@@ -107,7 +72,7 @@ namespace refine2
         return toks;
     }
 
-    static Problem parse_input_problem(const std::string &inputPath)
+    Problem parse_input_problem(const std::string &inputPath)
     {
         Problem pb;
         std::vector<std::string> t = read_tokens(inputPath);
@@ -174,11 +139,13 @@ namespace refine2
             }
         }
 
-        // Build name->id map for soft modules
-        std::unordered_map<std::string, int> softId;
-        softId.reserve(pb.soft.size() * 2 + 8);
+        // Build name->id map (soft first, then fixed)
+        std::unordered_map<std::string, int> modId;
+        modId.reserve((pb.soft.size() + pb.fixed.size()) * 2 + 8);
         for (int id = 0; id < (int)pb.soft.size(); ++id)
-            softId[pb.soft[id].name] = id;
+            modId[pb.soft[id].name] = id;
+        for (int k = 0; k < (int)pb.fixed.size(); ++k)
+            modId[pb.fixed[k].name] = (int)pb.soft.size() + k;
 
         // 2nd pass: parse CONNECTION
         t = read_tokens(inputPath);
@@ -205,9 +172,9 @@ namespace refine2
                     if (w <= 0)
                         continue;
 
-                    std::unordered_map<std::string, int>::const_iterator ia = softId.find(aName);
-                    std::unordered_map<std::string, int>::const_iterator ib = softId.find(bName);
-                    need(ia != softId.end() && ib != softId.end(),
+                    std::unordered_map<std::string, int>::const_iterator ia = modId.find(aName);
+                    std::unordered_map<std::string, int>::const_iterator ib = modId.find(bName);
+                    need(ia != modId.end() && ib != modId.end(),
                          "CONNECTION references unknown module: " + aName + " or " + bName);
 
                     Connection e;
@@ -219,16 +186,23 @@ namespace refine2
             }
         }
 
-        // Build adjacency
+        build_adjacency(pb);
+        return pb;
+    }
+
+    void build_adjacency(Problem &pb)
+    {
+        // fixed endpoints get no list of their own: they never move
+        const int n = (int)pb.soft.size();
         pb.adj.assign(pb.soft.size(), std::vector<std::pair<int, int>>());
         for (size_t k = 0; k < pb.conns.size(); ++k)
         {
             const Connection &e = pb.conns[k];
-            pb.adj[e.a].push_back(std::make_pair(e.b, e.w));
-            pb.adj[e.b].push_back(std::make_pair(e.a, e.w));
+            if (e.a < n)
+                pb.adj[e.a].push_back(std::make_pair(e.b, e.w));
+            if (e.b < n)
+                pb.adj[e.b].push_back(std::make_pair(e.a, e.w));
         }
-
-        return pb;
     }
 
     static Stage1Placement parse_stage1_output(const std::string &stage1Path, const Problem &pb)
@@ -308,16 +282,76 @@ namespace refine2
 
     // -------- Grid --------
 
+    // any bit set in [a,b) of a packed bit array
+    static inline bool bits_any(const uint64_t *w, int a, int b)
+    {
+        if (a >= b)
+            return false;
+        const int wa = a >> 6, wb = (b - 1) >> 6;
+        const uint64_t ma = ~0ULL << (a & 63);
+        const uint64_t mb = ~0ULL >> (63 - ((b - 1) & 63));
+        if (wa == wb)
+            return (w[wa] & ma & mb) != 0;
+        if (w[wa] & ma)
+            return true;
+        for (int k = wa + 1; k < wb; ++k)
+            if (w[k])
+                return true;
+        return (w[wb] & mb) != 0;
+    }
+
+    // set bits [a,b) of a packed bit array
+    static inline void bits_fill(uint64_t *w, int a, int b)
+    {
+        if (a >= b)
+            return;
+        const int wa = a >> 6, wb = (b - 1) >> 6;
+        const uint64_t ma = ~0ULL << (a & 63);
+        const uint64_t mb = ~0ULL >> (63 - ((b - 1) & 63));
+        if (wa == wb)
+        {
+            w[wa] |= ma & mb;
+            return;
+        }
+        w[wa] |= ma;
+        for (int k = wa + 1; k < wb; ++k)
+            w[k] = ~0ULL;
+        w[wb] |= mb;
+    }
+
+    // Occupancy only: one bit per cell, kept both row-major (row y covers x)
+    // and column-major (column x covers y), so a strip query or fill on either
+    // axis is a run of word operations. Cells never become free again.
     struct Grid
     {
         int W, H;
-        std::vector<int16_t> occ;
+        int rowWords, colWords;
+        std::vector<uint64_t> rowBits, colBits;
+
+        Grid(int w, int h)
+            : W(w), H(h),
+              rowWords((w + 63) / 64), colWords((h + 63) / 64),
+              rowBits((size_t)h * (size_t)((w + 63) / 64), 0),
+              colBits((size_t)w * (size_t)((h + 63) / 64), 0) {}
 
-        Grid(int w, int h) : W(w), H(h), occ((size_t)w * (size_t)h, EMPTY) {}
+        inline bool row_free(int y, int x1, int x2) const { return !bits_any(&rowBits[(size_t)y * rowWords], x1, x2); }
+        inline bool col_free(int x, int y1, int y2) const { return !bits_any(&colBits[(size_t)x * colWords], y1, y2); }
 
-        inline int idx(int x, int y) const { return y * W + x; }
-        inline int16_t get(int x, int y) const { return occ[(size_t)idx(x, y)]; }
-        inline void set(int x, int y, int16_t v) { occ[(size_t)idx(x, y)] = v; }
+        bool rect_free(const Rect &r) const
+        {
+            for (int y = r.y1; y < r.y2; ++y)
+                if (!row_free(y, r.x1, r.x2))
+                    return false;
+            return true;
+        }
+
+        void fill_rect(const Rect &r)
+        {
+            for (int y = r.y1; y < r.y2; ++y)
+                bits_fill(&rowBits[(size_t)y * rowWords], r.x1, r.x2);
+            for (int x = r.x1; x < r.x2; ++x)
+                bits_fill(&colBits[(size_t)x * colWords], r.y1, r.y2);
+        }
     };
 
     static void validate_initial(const Problem &pb, const std::vector<Rect> &softRects)
@@ -342,14 +376,23 @@ namespace refine2
         }
     }
 
-    static double total_hpwl(const Problem &pb, const std::vector<Rect> &rects)
+    // rectangle of module id j (soft or fixed)
+    static inline const Rect &module_rect(const Problem &pb, const std::vector<Rect> &rects, int j)
+    {
+        const int n = (int)rects.size();
+        return j < n ? rects[j] : pb.fixed[j - n].r;
+    }
+
+    double total_hpwl(const Problem &pb, const std::vector<Rect> &rects)
     {
         double s = 0.0;
         for (size_t k = 0; k < pb.conns.size(); ++k)
         {
             const Connection &e = pb.conns[k];
-            const double dx = std::fabs(rect_cx(rects[e.a]) - rect_cx(rects[e.b]));
-            const double dy = std::fabs(rect_cy(rects[e.a]) - rect_cy(rects[e.b]));
+            const Rect &ra = module_rect(pb, rects, e.a);
+            const Rect &rb = module_rect(pb, rects, e.b);
+            const double dx = std::fabs(rect_cx(ra) - rect_cx(rb));
+            const double dy = std::fabs(rect_cy(ra) - rect_cy(rb));
             s += (dx + dy) * double(e.w);
         }
         return s;
@@ -368,8 +411,9 @@ namespace refine2
             const int j = v[k].first;
             const int w = v[k].second;
 
-            const double jx = rect_cx(rects[j]);
-            const double jy = rect_cy(rects[j]);
+            const Rect &rj = module_rect(pb, rects, j);
+            const double jx = rect_cx(rj);
+            const double jy = rect_cy(rj);
 
             const double oldD = std::fabs(ox - jx) + std::fabs(oy - jy);
             const double newD = std::fabs(nx - jx) + std::fabs(ny - jy);
@@ -386,170 +430,79 @@ namespace refine2
         UP = 3
     };
 
-    static Dir primary_dir_for_module(const Problem &pb, int i, const std::vector<Rect> &rects)
-    {
-        double sumW = 0.0, tx = 0.0, ty = 0.0;
-        const std::vector<std::pair<int, int>> &v = pb.adj[i];
-        for (size_t k = 0; k < v.size(); ++k)
-        {
-            const int j = v[k].first;
-            const int w = v[k].second;
-            sumW += double(w);
-            tx += double(w) * rect_cx(rects[j]);
-            ty += double(w) * rect_cy(rects[j]);
-        }
-        if (sumW <= 0.0)
-            return RIGHT;
-
-        tx /= sumW;
-        ty /= sumW;
-        const double vx = tx - rect_cx(rects[i]);
-        const double vy = ty - rect_cy(rects[i]);
-
-        if (std::fabs(vx) >= std::fabs(vy))
-            return (vx >= 0.0) ? RIGHT : LEFT;
-        return (vy >= 0.0) ? UP : DOWN;
-    }
-
-    static double priority_score(const Problem &pb, int i, const std::vector<Rect> &rects)
-    {
-        double sumW = 0.0, tx = 0.0, ty = 0.0;
-        const std::vector<std::pair<int, int>> &v = pb.adj[i];
-        for (size_t k = 0; k < v.size(); ++k)
-        {
-            const int j = v[k].first;
-            const int w = v[k].second;
-            sumW += double(w);
-            tx += double(w) * rect_cx(rects[j]);
-            ty += double(w) * rect_cy(rects[j]);
-        }
-        if (sumW <= 0.0)
-            return 0.0;
-        tx /= sumW;
-        ty /= sumW;
-        const double vx = tx - rect_cx(rects[i]);
-        const double vy = ty - rect_cy(rects[i]);
-        return sumW * (std::fabs(vx) + std::fabs(vy));
-    }
-
-    static void dir_order(Dir primary, Dir out[4])
-    {
-        // primary, two perpendiculars, opposite
-        if (primary == LEFT)
-        {
-            out[0] = LEFT;
-            out[1] = UP;
-            out[2] = DOWN;
-            out[3] = RIGHT;
-            return;
-        }
-        if (primary == RIGHT)
-        {
-            out[0] = RIGHT;
-            out[1] = UP;
-            out[2] = DOWN;
-            out[3] = LEFT;
-            return;
-        }
-        if (primary == UP)
-        {
-            out[0] = UP;
-            out[1] = LEFT;
-            out[2] = RIGHT;
-            out[3] = DOWN;
-            return;
-        }
-        // DOWN
-        out[0] = DOWN;
-        out[1] = LEFT;
-        out[2] = RIGHT;
-        out[3] = UP;
-    }
-
-    static Rect expanded_rect(const Rect &r, Dir d)
+    static Rect expanded_rect(const Rect &r, Dir d, int step = 1)
     {
         Rect nr = r;
         if (d == RIGHT)
-            nr.x2 += 1;
+            nr.x2 += step;
         else if (d == LEFT)
-            nr.x1 -= 1;
+            nr.x1 -= step;
         else if (d == UP)
-            nr.y2 += 1;
+            nr.y2 += step;
         else
-            nr.y1 -= 1; // DOWN
+            nr.y1 -= step; // DOWN
         return nr;
     }
 
     static bool strip_empty(const Grid &g, const Rect &oldR, Dir d)
     {
-        if (d == RIGHT)
+        if (d == RIGHT || d == LEFT)
         {
-            const int x = oldR.x2;
+            const int x = (d == RIGHT) ? oldR.x2 : oldR.x1 - 1;
             if (x < 0 || x >= g.W)
                 return false;
-            for (int y = oldR.y1; y < oldR.y2; ++y)
-                if (g.get(x, y) != EMPTY)
-                    return false;
-            return true;
+            return g.col_free(x, oldR.y1, oldR.y2);
         }
-        if (d == LEFT)
-        {
-            const int x = oldR.x1 - 1;
-            if (x < 0 || x >= g.W)
-                return false;
-            for (int y = oldR.y1; y < oldR.y2; ++y)
-                if (g.get(x, y) != EMPTY)
-                    return false;
-            return true;
-        }
-        if (d == UP)
-        {
-            const int y = oldR.y2;
-            if (y < 0 || y >= g.H)
-                return false;
-            for (int x = oldR.x1; x < oldR.x2; ++x)
-                if (g.get(x, y) != EMPTY)
-                    return false;
-            return true;
-        }
-        // DOWN
-        const int y = oldR.y1 - 1;
+        // UP / DOWN
+        const int y = (d == UP) ? oldR.y2 : oldR.y1 - 1;
         if (y < 0 || y >= g.H)
             return false;
-        for (int x = oldR.x1; x < oldR.x2; ++x)
-            if (g.get(x, y) != EMPTY)
+        return g.row_free(y, oldR.x1, oldR.x2);
+    }
+
+    // `step` consecutive strips beyond oldR in direction d
+    static bool band_empty(const Grid &g, const Rect &oldR, Dir d, int step)
+    {
+        Rect r = oldR;
+        for (int k = 0; k < step; ++k)
+        {
+            if (!strip_empty(g, r, d))
                 return false;
+            r = expanded_rect(r, d);
+        }
         return true;
     }
 
-    static void paint_new_strip(Grid &g, const Rect &oldR, Dir d, int softId)
+    // the cells expanded_rect(oldR, d, step) adds to oldR
+    static Rect band_rect(const Rect &oldR, Dir d, int step)
     {
-        const int16_t id = (int16_t)softId;
+        Rect r = oldR;
         if (d == RIGHT)
         {
-            const int x = oldR.x2;
-            for (int y = oldR.y1; y < oldR.y2; ++y)
-                g.set(x, y, id);
-            return;
+            r.x1 = oldR.x2;
+            r.x2 = oldR.x2 + step;
         }
-        if (d == LEFT)
+        else if (d == LEFT)
         {
-            const int x = oldR.x1 - 1;
-            for (int y = oldR.y1; y < oldR.y2; ++y)
-                g.set(x, y, id);
-            return;
+            r.x2 = oldR.x1;
+            r.x1 = oldR.x1 - step;
         }
-        if (d == UP)
+        else if (d == UP)
         {
-            const int y = oldR.y2;
-            for (int x = oldR.x1; x < oldR.x2; ++x)
-                g.set(x, y, id);
-            return;
+            r.y1 = oldR.y2;
+            r.y2 = oldR.y2 + step;
+        }
+        else // DOWN
+        {
+            r.y2 = oldR.y1;
+            r.y1 = oldR.y1 - step;
         }
-        // DOWN
-        const int y = oldR.y1 - 1;
-        for (int x = oldR.x1; x < oldR.x2; ++x)
-            g.set(x, y, id);
+        return r;
+    }
+
+    static void paint_new_band(Grid &g, const Rect &oldR, Dir d, int step)
+    {
+        g.fill_rect(band_rect(oldR, d, step));
     }
 
     static void build_grid_or_throw(const Problem &pb, const std::vector<Rect> &softRects, Grid &grid)
@@ -564,33 +517,124 @@ namespace refine2
             {
                 throw std::runtime_error("Fixed module out of chip: " + fm.name);
             }
-            for (int y = r.y1; y < r.y2; ++y)
-            {
-                for (int x = r.x1; x < r.x2; ++x)
-                {
-                    if (grid.get(x, y) != EMPTY)
-                        throw std::runtime_error("Fixed overlaps fixed: " + fm.name);
-                    grid.set(x, y, FIXED);
-                }
-            }
+            if (!grid.rect_free(r))
+                throw std::runtime_error("Fixed overlaps fixed: " + fm.name);
+            grid.fill_rect(r);
         }
 
         // Paint soft
         for (int sid = 0; sid < (int)softRects.size(); ++sid)
         {
             const Rect &r = softRects[sid];
-            for (int y = r.y1; y < r.y2; ++y)
+            if (!grid.rect_free(r))
+                throw std::runtime_error("Initial soft overlaps: " + pb.soft[sid].name);
+            grid.fill_rect(r);
+        }
+    }
+
+    struct Move
+    {
+        Dir d;
+        int step;
+        double gain; // -dHPWL, > 0 means improving
+        Move() : d(RIGHT), step(0), gain(0.0) {}
+    };
+
+    // Largest step in direction d whose every unit is legal (boundary, aspect,
+    // free strip) and still lowers HPWL. dHPWL(step) is convex in the step, so
+    // "the k-th unit still helps" holds on a prefix: gallop 1,2,4,... until it
+    // fails, then binary-search back. Returns 0 if even one unit does not help.
+    static int gallop_step(const Problem &pb, int i, const std::vector<Rect> &rects, const Grid &grid,
+                           Dir d, double &dHPWL)
+    {
+        const Rect &oldR = rects[i];
+        std::vector<double> memo; // memo[k] = dHPWL for step k (NaN = unknown)
+        auto dh = [&](int k) -> double
+        {
+            if ((int)memo.size() <= k)
+                memo.resize(k + 1, std::numeric_limits<double>::quiet_NaN());
+            if (k == 0)
+                return memo[0] = 0.0;
+            if (memo[k] != memo[k]) // NaN
+                memo[k] = delta_hpwl_for_move(pb, i, oldR, expanded_rect(oldR, d, k), rects);
+            return memo[k];
+        };
+        // unit k is legal and improving; strips good+1..k must be free
+        auto ok = [&](int good, int k) -> bool
+        {
+            const Rect newR = expanded_rect(oldR, d, k);
+            if (!(0 <= newR.x1 && newR.x1 < newR.x2 && newR.x2 <= pb.W &&
+                  0 <= newR.y1 && newR.y1 < newR.y2 && newR.y2 <= pb.H))
+                return false;
+            if (!aspect_ok(newR))
+                return false;
+            if (!(dh(k) - dh(k - 1) < -1e-9))
+                return false;
+            return band_empty(grid, expanded_rect(oldR, d, good), d, k - good);
+        };
+
+        if (!ok(0, 1))
+            return 0;
+        int good = 1, bad = 2;
+        while (ok(good, bad))
+        {
+            good = bad;
+            bad *= 2;
+        }
+        while (bad - good > 1)
+        {
+            const int mid = good + (bad - good) / 2;
+            if (ok(good, mid))
+                good = mid;
+            else
+                bad = mid;
+        }
+        dHPWL = dh(good);
+        return good;
+    }
+
+    // Best legal galloping expansion of module i; false if none improves HPWL.
+    static bool best_move(const Problem &pb, int i, const std::vector<Rect> &rects, const Grid &grid, Move &out)
+    {
+        static const Dir dirs[4] = {LEFT, RIGHT, DOWN, UP};
+        bool found = false;
+        for (int k = 0; k < 4; ++k)
+        {
+            double dHPWL = 0.0;
+            const int step = gallop_step(pb, i, rects, grid, dirs[k], dHPWL);
+            if (step <= 0)
+                continue;
+            const double gain = -dHPWL;
+            if (!found || gain > out.gain)
             {
-                for (int x = r.x1; x < r.x2; ++x)
-                {
-                    if (grid.get(x, y) != EMPTY)
-                        throw std::runtime_error("Initial soft overlaps: " + pb.soft[sid].name);
-                    grid.set(x, y, (int16_t)sid);
-                }
+                out.d = dirs[k];
+                out.step = step;
+                out.gain = gain;
+                found = true;
             }
         }
+        return found;
     }
 
+    struct HeapEntry
+    {
+        double gain;
+        int i;
+        int stamp;
+        Dir d;
+        int step;
+        bool operator<(const HeapEntry &o) const
+        {
+            if (gain != o.gain)
+                return gain < o.gain;
+            return i > o.i; // lower id first on ties
+        }
+    };
+
+    // Always apply the globally best move. A move of i only changes the gains
+    // of i and its adj neighbours (center shift), so those are rescored
+    // eagerly. Everyone else can only lose strips to the grid fill, so a popped
+    // entry with a current stamp just re-checks that its own band is still free.
     static void refine_grow_rectangles(const Problem &pb,
                                        std::vector<Rect> &softRects,
                                        Grid &grid,
@@ -598,70 +642,62 @@ namespace refine2
                                        int maxMovesPerModulePerPass)
     {
         const int n = (int)softRects.size();
+        std::vector<int> stamp(n, 0);
 
         for (int pass = 0; pass < passes; ++pass)
         {
-            std::vector<int> order(n);
-            std::iota(order.begin(), order.end(), 0);
+            std::vector<int> moves(n, 0);
+            std::priority_queue<HeapEntry> heap;
+
+            auto rescore = [&](int i)
+            {
+                ++stamp[i];
+                if (pb.adj[i].empty() || moves[i] >= maxMovesPerModulePerPass)
+                    return;
+                Move mv;
+                if (best_move(pb, i, softRects, grid, mv))
+                {
+                    HeapEntry e;
+                    e.gain = mv.gain;
+                    e.i = i;
+                    e.stamp = stamp[i];
+                    e.d = mv.d;
+                    e.step = mv.step;
+                    heap.push(e);
+                }
+            };
 
-            std::stable_sort(order.begin(), order.end(),
-                             [&](int a, int b)
-                             { return priority_score(pb, a, softRects) > priority_score(pb, b, softRects); });
+            for (int i = 0; i < n; ++i)
+                rescore(i);
 
             bool any = false;
-
-            for (int oi = 0; oi < n; ++oi)
+            while (!heap.empty())
             {
-                const int i = order[oi];
-                if (pb.adj[i].empty())
+                const HeapEntry e = heap.top();
+                heap.pop();
+                const int i = e.i;
+                if (e.stamp != stamp[i])
                     continue;
 
-                int moves = 0;
-                while (moves < maxMovesPerModulePerPass)
+                const Rect oldR = softRects[i];
+                if (!band_empty(grid, oldR, e.d, e.step))
                 {
-                    const Dir primary = primary_dir_for_module(pb, i, softRects);
-                    Dir dirs[4];
-                    dir_order(primary, dirs);
-
-                    bool moved = false;
-                    for (int k = 0; k < 4; ++k)
-                    {
-                        const Dir d = dirs[k];
-                        const Rect oldR = softRects[i];
-                        const Rect newR = expanded_rect(oldR, d);
-
-                        // boundary
-                        if (!(0 <= newR.x1 && newR.x1 < newR.x2 && newR.x2 <= pb.W &&
-                              0 <= newR.y1 && newR.y1 < newR.y2 && newR.y2 <= pb.H))
-                        {
-                            continue;
-                        }
-
-                        // aspect ratio
-                        if (!aspect_ok(newR))
-                            continue;
-
-                        // new strip empty?
-                        if (!strip_empty(grid, oldR, d))
-                            continue;
-
-                        // delta HPWL
-                        const double dHPWL = delta_hpwl_for_move(pb, i, oldR, newR, softRects);
-                        if (!(dHPWL < -1e-9))
-                            continue;
-
-                        // accept
-                        paint_new_strip(grid, oldR, d, i);
-                        softRects[i] = newR;
-                        any = true;
-                        moved = true;
-                        moves++;
-                        break;
-                    }
-
-                    if (!moved)
-                        break;
+                    // band got taken since scoring; requeue with the next best move
+                    rescore(i);
+                    continue;
                 }
+
+                // accept
+                paint_new_band(grid, oldR, e.d, e.step);
+                softRects[i] = expanded_rect(oldR, e.d, e.step);
+                any = true;
+                moves[i]++;
+
+                rescore(i);
+                const std::vector<std::pair<int, int>> &v = pb.adj[i];
+                for (size_t k = 0; k < v.size(); ++k)
+                    if (v[k].first < n)
+                        rescore(v[k].first);
             }
 
             if (!any)
@@ -669,7 +705,7 @@ namespace refine2
         }
     }
 
-    static void write_output(const std::string &outPath, const Problem &pb, const std::vector<Rect> &softRects)
+    void write_output(const std::string &outPath, const Problem &pb, const std::vector<Rect> &softRects)
     {
         std::ofstream ofs(outPath.c_str());
         if (!ofs)
@@ -691,6 +727,20 @@ namespace refine2
         }
     }
 
+    double refine(const Problem &pb, std::vector<Rect> &softRects,
+                  int passes, int maxMovesPerModulePerPass)
+    {
+        validate_initial(pb, softRects);
+
+        Grid grid(pb.W, pb.H);
+        build_grid_or_throw(pb, softRects, grid);
+
+        // Tune these if you want “stronger” refinement
+        refine_grow_rectangles(pb, softRects, grid, passes, maxMovesPerModulePerPass);
+
+        return total_hpwl(pb, softRects);
+    }
+
     int run(const std::string &inputPath,
             const std::string &stage1OutPath,
             const std::string &outPath,
@@ -701,13 +751,7 @@ namespace refine2
         Stage1Placement st = parse_stage1_output(stage1OutPath, pb);
 
         std::vector<Rect> softRects = st.softRects;
-        validate_initial(pb, softRects);
-
-        Grid grid(pb.W, pb.H);
-        build_grid_or_throw(pb, softRects, grid);
-
-        // Tune these if you want “stronger” refinement
-        refine_grow_rectangles(pb, softRects, grid, passes, maxMovesPerModulePerPass);
+        refine(pb, softRects, passes, maxMovesPerModulePerPass);
 
         write_output(outPath, pb, softRects);
         return 0;
@@ -0,0 +1,79 @@
+// refiner.h
+// Library interface of the stage-2 refiner (refine2).
+//
+// The standalone binary (refiner.cpp built with -DREFINE_STANDALONE) reads the
+// problem and a stage-1 output file; an in-process caller (pipeline.cpp) builds
+// the Problem and the initial soft rectangles itself and calls refine().
+//
+// Module ids: soft modules are [0, soft.size()), fixed modules follow at
+// soft.size() + k. Rectangle vectors passed in/out hold soft modules only.
+
+#ifndef REFINER_H
+#define REFINER_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace refine2
+{
+    struct Rect
+    {
+        int x1, y1, x2, y2; // half-open: [x1,x2) x [y1,y2)
+        Rect() : x1(0), y1(0), x2(0), y2(0) {}
+    };
+
+    struct SoftSpec
+    {
+        std::string name;
+        int minArea;
+        SoftSpec() : name(), minArea(0) {}
+    };
+
+    struct FixedMod
+    {
+        std::string name;
+        Rect r;
+    };
+
+    struct Connection
+    {
+        int a, b; // module ids (soft first, then fixed)
+        int w;
+        Connection() : a(-1), b(-1), w(0) {}
+    };
+
+    struct Problem
+    {
+        int W, H;
+        std::vector<SoftSpec> soft;
+        std::vector<FixedMod> fixed;
+        std::vector<Connection> conns;
+        std::vector<std::vector<std::pair<int, int>>> adj; // adj[soft i] = (neighbor id, weight)
+        Problem() : W(0), H(0) {}
+    };
+
+    // Parse CHIP / SOFTMODULE / FIXEDMODULE / CONNECTION; adj is built.
+    Problem parse_input_problem(const std::string &inputPath);
+
+    // (Re)build pb.adj from pb.conns. Call after filling conns by hand.
+    void build_adjacency(Problem &pb);
+
+    // Validate softRects against pb, grow them in place and return the final HPWL.
+    // Throws std::runtime_error if the initial placement is illegal.
+    double refine(const Problem &pb, std::vector<Rect> &softRects,
+                  int passes, int maxMovesPerModulePerPass);
+
+    double total_hpwl(const Problem &pb, const std::vector<Rect> &softRects);
+
+    void write_output(const std::string &outPath, const Problem &pb, const std::vector<Rect> &softRects);
+
+    // File-to-file driver used by the standalone binary.
+    int run(const std::string &inputPath,
+            const std::string &stage1OutPath,
+            const std::string &outPath,
+            int passes,
+            int maxMovesPerModulePerPass);
+} // namespace refine2
+
+#endif // REFINER_H
@@ -854,12 +854,30 @@ using namespace std;
 
 /*
   Build:
-    g++ -O3 -march=native -std=c++17 refiner_pixel_even.cpp -o refiner_stage2
+    g++ -O3 -march=native -std=c++17 -pthread refiner_pixel_even.cpp -o refiner_stage2
 
   Run:
-    ./refiner_stage2 <input_problem.txt> <stage1.out> <final.out>
+    ./refiner_stage2 <input_problem.txt> <stage1.out> <final.out> [threads]
+                     [--deadline=seconds] [--checkpoint=file]
+
+  threads defaults to the number of hardware threads.
+
+  Every accepted growth step keeps the placement legal, so the refiner can stop
+  between modules at any time: at the deadline (counted from start) or on
+  SIGTERM/SIGINT it stops growing and writes the current placement. With a
+  checkpoint file the placement is also saved every checkpointEvery seconds;
+  if the file already exists it is used instead of the stage-1 output.
+  Output and checkpoint are written to <file>.tmp and renamed into place.
 */
 
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onStopSignal(int sig)
+{
+    stopRequested = 1;
+    signal(sig, SIG_DFL); // a second signal terminates as usual
+}
+
 enum class ModType
 {
     SOFT,
@@ -910,6 +928,17 @@ struct Module
     // streak penalty for bbox-extending side
     // 0:left 1:right 2:down 3:up
     int sideStreak[4] = {0, 0, 0, 0};
+
+    // outline read from a polygonal stage-1 file (a resumed checkpoint);
+    // empty for plain rectangles
+    vector<pair<int, int>> poly;
+
+    // growth window [winMinx,winMaxx) x [winMiny,winMaxy); whole chip unless
+    // the parallel scheduler restricts it for the current round
+    int winMinx = 0, winMiny = 0, winMaxx = INT_MAX, winMaxy = INT_MAX;
+
+    // per-module RNG stream for parallel rounds
+    uint64_t rng = 0;
 };
 
 class RefinerPixelEven
@@ -932,6 +961,11 @@ public:
     int maxRounds = 500;
     int maxStepsPerModPerRound = 500;
 
+    // strip moves: claim a whole free row/column along one bbox side per step,
+    // pixel moves then only smooth what strips could not reach
+    bool useStripMoves = true;
+    int maxStripsPerModPerRound = 200;
+
     // constraints
     double aspectMin = 0.5;
     double aspectMax = 2.0;
@@ -951,6 +985,26 @@ public:
     int pickTopK = 8; // pick randomly among top K scored candidates (K=1 => deterministic)
     uint64_t rngSeed = 1234567;
 
+    // parallel expansion: modules whose windows (bbox + parallelMargin) do not
+    // touch are grouped and expanded concurrently (numThreads <= 1 => sequential)
+    int numThreads = 1;
+    int parallelMargin = 64;
+
+    // neighbour centers frozen at the start of a parallel group
+    bool useSnapshot = false;
+    vector<double> snapCx, snapCy;
+
+    // anytime control (see the header comment)
+    bool hasDeadline = false;
+    chrono::steady_clock::time_point deadline;
+    string checkpointPath;
+    double checkpointEvery = 30.0; // seconds
+
+    bool shouldStop() const
+    {
+        return stopRequested || (hasDeadline && chrono::steady_clock::now() >= deadline);
+    }
+
     // ---------------- parsing ----------------
     void parseProblem(const string &filename)
     {
@@ -1060,15 +1114,23 @@ public:
             int id = name2id.at(nm);
 
             int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+            vector<pair<int, int>> pts(k);
+            long long twiceArea = 0;
             for (int j = 0; j < k; j++)
             {
                 int x, y;
                 in >> x >> y;
+                pts[j] = {x, y};
                 minX = min(minX, x);
                 minY = min(minY, y);
                 maxX = max(maxX, x);
                 maxY = max(maxY, y);
             }
+            for (int j = 0; j < k; j++)
+            {
+                const auto &a = pts[j], &b = pts[(j + 1) % k];
+                twiceArea += 1LL * a.first * b.second - 1LL * b.first * a.second;
+            }
 
             mods[id].minx = minX;
             mods[id].miny = minY;
@@ -1080,6 +1142,14 @@ public:
             if (w <= 0 || h <= 0)
                 throw runtime_error("stage1: invalid rect for " + nm);
             mods[id].area = 1LL * w * h;
+
+            // anything but the full bbox is kept as an outline and painted as such
+            mods[id].poly.clear();
+            if (llabs(twiceArea) / 2 != mods[id].area)
+            {
+                mods[id].area = llabs(twiceArea) / 2;
+                mods[id].poly = pts;
+            }
         }
     }
 
@@ -1130,7 +1200,8 @@ public:
         for (const auto &e : adj[m.id])
         {
             const Module &o = mods[e.to];
-            double ox = centerX(o), oy = centerY(o);
+            double ox = useSnapshot ? snapCx[e.to] : centerX(o);
+            double oy = useSnapshot ? snapCy[e.to] : centerY(o);
             double old = fabs(oldCx - ox) + fabs(oldCy - oy);
             double neu = fabs(newCx - ox) + fabs(newCy - oy);
             d += (double)e.w * (neu - old);
@@ -1163,9 +1234,35 @@ public:
         for (auto &m : mods)
             if (m.type == ModType::FIXED)
                 paintRect(m.id, m.minx, m.miny, m.maxx, m.maxy);
+        // rectilinear outline, row by row between vertical-edge crossings
+        auto paintPoly = [&](int id, const vector<pair<int, int>> &poly)
+        {
+            const int k = (int)poly.size();
+            vector<int> xs;
+            for (int y = mods[id].miny; y < mods[id].maxy; y++)
+            {
+                xs.clear();
+                for (int j = 0; j < k; j++)
+                {
+                    const auto &a = poly[j], &b = poly[(j + 1) % k];
+                    if (a.first == b.first && min(a.second, b.second) <= y && y < max(a.second, b.second))
+                        xs.push_back(a.first);
+                }
+                sort(xs.begin(), xs.end());
+                for (size_t j = 0; j + 1 < xs.size(); j += 2)
+                    paintRect(id, xs[j], y, xs[j + 1], y + 1);
+            }
+        };
+
         for (auto &m : mods)
-            if (m.type == ModType::SOFT)
+        {
+            if (m.type != ModType::SOFT)
+                continue;
+            if (m.poly.empty())
                 paintRect(m.id, m.minx, m.miny, m.maxx, m.maxy);
+            else
+                paintPoly(m.id, m.poly);
+        }
 
         inFrontier.assign(mods.size(), vector<uint8_t>((size_t)chipW * (size_t)chipH, 0));
 
@@ -1176,7 +1273,10 @@ public:
             m.frontier.clear();
             m.hasLast = false;
             m.sideStreak[0] = m.sideStreak[1] = m.sideStreak[2] = m.sideStreak[3] = 0;
-            addFrontierFromBBoxBoundary(m);
+            if (m.poly.empty())
+                addFrontierFromBBoxBoundary(m);
+            else
+                addFrontierFromCells(m);
         }
     }
 
@@ -1207,6 +1307,20 @@ public:
         }
     }
 
+    // frontier of a non-rectangular module: free 4-neighbours of its cells
+    void addFrontierFromCells(Module &m)
+    {
+        for (int y = m.miny; y < m.maxy; y++)
+            for (int x = m.minx; x < m.maxx; x++)
+                if (grid[packCell(x, y, chipW)] == m.id)
+                {
+                    frontierAdd(m, x - 1, y);
+                    frontierAdd(m, x + 1, y);
+                    frontierAdd(m, x, y - 1);
+                    frontierAdd(m, x, y + 1);
+                }
+    }
+
     void updateFrontierAfterAdd(Module &m, int px, int py)
     {
         int p = packCell(px, py, chipW);
@@ -1218,10 +1332,17 @@ public:
     }
 
     // must be adjacent + legal if added
+    inline bool inWindow(const Module &m, int x, int y) const
+    {
+        return x >= m.winMinx && y >= m.winMiny && x < m.winMaxx && y < m.winMaxy;
+    }
+
     bool canAddPixel(const Module &m, int x, int y) const
     {
         if (x < 0 || y < 0 || x >= chipW || y >= chipH)
             return false;
+        if (!inWindow(m, x, y))
+            return false;
         int p = packCell(x, y, chipW);
         if (grid[p] != -1)
             return false;
@@ -1304,6 +1425,178 @@ public:
         updateFrontierAfterAdd(m, x, y);
     }
 
+    // ---------------- strip moves ----------------
+    // Longest free run on the row/column just outside bbox side (0:left 1:right 2:down 3:up),
+    // returned as cells [x0,x1) x [y0,y1). The run must touch the module from inside so the
+    // shape stays connected; legality is checked once for the whole run.
+    bool findStrip(const Module &m, int side, int &x0, int &y0, int &x1, int &y1) const
+    {
+        bool vertical = (side == 0 || side == 1);
+        int line, inner; // outside line and the bbox line next to it
+        if (side == 0)
+        {
+            line = m.minx - 1;
+            inner = m.minx;
+        }
+        else if (side == 1)
+        {
+            line = m.maxx;
+            inner = m.maxx - 1;
+        }
+        else if (side == 2)
+        {
+            line = m.miny - 1;
+            inner = m.miny;
+        }
+        else
+        {
+            line = m.maxy;
+            inner = m.maxy - 1;
+        }
+        if (line < 0 || line >= (vertical ? chipW : chipH))
+            return false;
+        if (vertical ? (line < m.winMinx || line >= m.winMaxx) : (line < m.winMiny || line >= m.winMaxy))
+            return false;
+
+        int lo = vertical ? m.miny : m.minx;
+        int hi = vertical ? m.maxy : m.maxx;
+        auto owner = [&](int l, int t) -> int
+        { return vertical ? grid[packCell(l, t, chipW)] : grid[packCell(t, l, chipW)]; };
+
+        int nminx = vertical ? min(m.minx, line) : m.minx;
+        int nmaxx = vertical ? max(m.maxx, line + 1) : m.maxx;
+        int nminy = vertical ? m.miny : min(m.miny, line);
+        int nmaxy = vertical ? m.maxy : max(m.maxy, line + 1);
+
+        int bestA = -1, bestB = -1;
+        for (int t = lo; t < hi;)
+        {
+            if (owner(line, t) != -1)
+            {
+                t++;
+                continue;
+            }
+            int a = t;
+            bool touches = false;
+            while (t < hi && owner(line, t) == -1)
+            {
+                if (owner(inner, t) == m.id)
+                    touches = true;
+                t++;
+            }
+            if (!touches || t - a <= bestB - bestA)
+                continue;
+            if (bboxLegal(m, nminx, nminy, nmaxx, nmaxy, m.area + (t - a)))
+            {
+                bestA = a;
+                bestB = t;
+            }
+        }
+        if (bestA < 0)
+            return false;
+
+        if (vertical)
+        {
+            x0 = line;
+            x1 = line + 1;
+            y0 = bestA;
+            y1 = bestB;
+        }
+        else
+        {
+            x0 = bestA;
+            x1 = bestB;
+            y0 = line;
+            y1 = line + 1;
+        }
+        return true;
+    }
+
+    void applyAddStrip(Module &m, int side, int x0, int y0, int x1, int y1)
+    {
+        for (int y = y0; y < y1; y++)
+        {
+            for (int x = x0; x < x1; x++)
+            {
+                int p = packCell(x, y, chipW);
+                grid[p] = m.id;
+                inFrontier[m.id][p] = 0;
+            }
+        }
+        m.area += 1LL * (x1 - x0) * (y1 - y0);
+
+        // one bbox extension on `side`
+        for (int i = 0; i < 4; i++)
+        {
+            if (i == side)
+                m.sideStreak[i] += 1;
+            else
+                m.sideStreak[i] = max(0, m.sideStreak[i] - 1);
+        }
+
+        m.minx = min(m.minx, x0);
+        m.miny = min(m.miny, y0);
+        m.maxx = max(m.maxx, x1);
+        m.maxy = max(m.maxy, y1);
+
+        m.hasLast = true;
+        m.lastX = (x0 + x1 - 1) / 2;
+        m.lastY = (y0 + y1 - 1) / 2;
+
+        // bulk frontier update: both lines along the strip plus its two end cells
+        if (side == 0 || side == 1)
+        {
+            for (int y = y0; y < y1; y++)
+            {
+                frontierAdd(m, x0 - 1, y);
+                frontierAdd(m, x0 + 1, y);
+            }
+            frontierAdd(m, x0, y0 - 1);
+            frontierAdd(m, x0, y1);
+        }
+        else
+        {
+            for (int x = x0; x < x1; x++)
+            {
+                frontierAdd(m, x, y0 - 1);
+                frontierAdd(m, x, y0 + 1);
+            }
+            frontierAdd(m, x0 - 1, y0);
+            frontierAdd(m, x1, y0);
+        }
+    }
+
+    // claim the best strip; only strictly improving strips are taken,
+    // neutral growth is left to the pixel moves
+    bool expandStripStep(Module &m)
+    {
+        int bestSide = -1, bx0 = 0, by0 = 0, bx1 = 0, by1 = 0;
+        double bestDHP = 0.0;
+        long long bestLen = 0;
+        for (int side = 0; side < 4; side++)
+        {
+            int x0, y0, x1, y1;
+            if (!findStrip(m, side, x0, y0, x1, y1))
+                continue;
+            double dHP = deltaHPWL_bbox(m, min(m.minx, x0), min(m.miny, y0), max(m.maxx, x1), max(m.maxy, y1));
+            long long len = 1LL * (x1 - x0) * (y1 - y0);
+            if (dHP < bestDHP || (bestSide >= 0 && dHP == bestDHP && len > bestLen))
+            {
+                bestDHP = dHP;
+                bestLen = len;
+                bestSide = side;
+                bx0 = x0;
+                by0 = y0;
+                bx1 = x1;
+                by1 = y1;
+            }
+        }
+        if (bestSide < 0)
+            return false;
+        applyAddStrip(m, bestSide, bx0, by0, bx1, by1);
+        return true;
+    }
+
     // ---------------- forces / order ----------------
     void computeForces()
     {
@@ -1327,18 +1620,18 @@ public:
     }
 
     // RNG
-    uint64_t xorshift64()
+    static uint64_t xorshift64(uint64_t &state)
     {
-        uint64_t x = rngSeed;
+        uint64_t x = state;
         x ^= x << 13;
         x ^= x >> 7;
         x ^= x << 17;
-        rngSeed = x;
+        state = x;
         return x;
     }
 
     // pick one pixel to add (EVEN growth scoring)
-    bool expandOneStep(Module &m)
+    bool expandOneStep(Module &m, uint64_t &rng)
     {
         if (m.frontier.empty())
             return false;
@@ -1378,13 +1671,15 @@ public:
             int p = m.frontier[i];
             if (!inFrontier[m.id][p])
                 continue;
+            int x = cellX(p, chipW), y = cellY(p, chipW);
+            if (!inWindow(m, x, y))
+                continue; // may belong to a concurrently growing module
             if (grid[p] != -1)
             {
                 inFrontier[m.id][p] = 0;
                 continue;
             }
 
-            int x = cellX(p, chipW), y = cellY(p, chipW);
             if (!canAddPixel(m, x, y))
                 continue;
 
@@ -1451,7 +1746,7 @@ public:
             w[i] = best[i].score + shift;
             totalW += w[i];
         }
-        uint64_t r = xorshift64();
+        uint64_t r = xorshift64(rng);
         double u = (double)(r % 1000000ULL) / 1000000.0;
         double t = u * totalW;
 
@@ -1477,8 +1772,129 @@ public:
     }
 
     // ---------------- optimize ----------------
+    struct GrowStat
+    {
+        long long grown = 0;
+        int strips = 0, adds = 0;
+    };
+
+    GrowStat growModule(Module &m, uint64_t &rng)
+    {
+        GrowStat st;
+        long long areaBefore = m.area;
+        if (useStripMoves)
+        {
+            for (int step = 0; step < maxStripsPerModPerRound; step++)
+            {
+                if (!expandStripStep(m))
+                    break;
+                st.strips++;
+            }
+        }
+        for (int step = 0; step < maxStepsPerModPerRound; step++)
+        {
+            if (!expandOneStep(m, rng))
+                break;
+            st.adds++;
+        }
+        st.grown = m.area - areaBefore;
+        return st;
+    }
+
+    // Greedy first-fit grouping (in force order) of modules whose windows,
+    // grown by one cell of read halo, do not intersect. Within a group no two
+    // modules can read or write the same pixel, so a pixel wanted by two
+    // modules is always settled by group order, which is deterministic.
+    vector<vector<int>> buildParallelGroups(const vector<int> &order)
+    {
+        for (int id : order)
+        {
+            Module &m = mods[id];
+            m.winMinx = max(0, m.minx - parallelMargin);
+            m.winMiny = max(0, m.miny - parallelMargin);
+            m.winMaxx = min(chipW, m.maxx + parallelMargin);
+            m.winMaxy = min(chipH, m.maxy + parallelMargin);
+        }
+        auto touches = [&](const Module &a, const Module &b)
+        {
+            return a.winMinx - 1 < b.winMaxx && b.winMinx < a.winMaxx + 1 &&
+                   a.winMiny - 1 < b.winMaxy && b.winMiny < a.winMaxy + 1;
+        };
+
+        vector<vector<int>> groups;
+        for (int id : order)
+        {
+            bool placed = false;
+            for (auto &g : groups)
+            {
+                bool ok = true;
+                for (int o : g)
+                    if (touches(mods[id], mods[o]))
+                    {
+                        ok = false;
+                        break;
+                    }
+                if (ok)
+                {
+                    g.push_back(id);
+                    placed = true;
+                    break;
+                }
+            }
+            if (!placed)
+                groups.push_back({id});
+        }
+        return groups;
+    }
+
+    void growParallel(const vector<int> &order, int round, vector<GrowStat> &stats)
+    {
+        vector<vector<int>> groups = buildParallelGroups(order);
+
+        snapCx.assign(mods.size(), 0.0);
+        snapCy.assign(mods.size(), 0.0);
+        for (const auto &g : groups)
+        {
+            if (shouldStop())
+                break;
+            for (auto &m : mods)
+            {
+                snapCx[m.id] = centerX(m);
+                snapCy[m.id] = centerY(m);
+            }
+            for (int id : g)
+                mods[id].rng = rngSeed ^ (0x9E3779B97F4A7C15ULL * (uint64_t)(round * (int)mods.size() + id + 1));
+
+            useSnapshot = true;
+            atomic<size_t> next(0);
+            auto worker = [&]()
+            {
+                for (size_t k = next++; k < g.size(); k = next++)
+                {
+                    Module &m = mods[g[k]];
+                    stats[m.id] = growModule(m, m.rng);
+                }
+            };
+            int nt = (int)min<size_t>((size_t)numThreads, g.size());
+            vector<thread> pool;
+            for (int t = 1; t < nt; t++)
+                pool.emplace_back(worker);
+            worker();
+            for (auto &th : pool)
+                th.join();
+            useSnapshot = false;
+        }
+
+        for (auto &m : mods)
+        {
+            m.winMinx = m.winMiny = 0;
+            m.winMaxx = m.winMaxy = INT_MAX;
+        }
+    }
+
     void optimize()
     {
+        auto lastCheckpoint = chrono::steady_clock::now();
         for (int r = 1; r <= maxRounds; r++)
         {
             computeForces();
@@ -1496,30 +1912,48 @@ public:
         double mb=hypot(mods[b].fx,mods[b].fy);
         return ma>mb; });
 
-            long long roundAdds = 0;
-            for (int id : order)
-            {
-                Module &m = mods[id];
-                int adds = 0;
-                for (int step = 0; step < maxStepsPerModPerRound; step++)
+            vector<GrowStat> stats(mods.size());
+            if (numThreads > 1)
+                growParallel(order, r, stats);
+            else
+                for (int id : order)
                 {
-                    if (!expandOneStep(m))
+                    if (shouldStop())
                         break;
-                    adds++;
+                    stats[id] = growModule(mods[id], rngSeed);
                 }
-                if (adds > 0)
+
+            long long roundAdds = 0;
+            for (int id : order)
+            {
+                const GrowStat &st = stats[id];
+                if (st.grown > 0)
                 {
-                    roundAdds += adds;
-                    cout << "  Module " << m.name << " expanded by " << adds << " pixels\n";
+                    roundAdds += st.grown;
+                    cout << "  Module " << mods[id].name << " expanded by " << st.grown << " pixels ("
+                         << st.strips << " strips, " << st.adds << " single pixels)\n";
                 }
             }
 
+            if (shouldStop())
+            {
+                cout << "  Stopped (deadline or signal); keeping the current placement.\n";
+                break;
+            }
             if (roundAdds == 0)
             {
                 cout << "  No expansions accepted this round; stopping early.\n";
                 break;
             }
+            if (!checkpointPath.empty() &&
+                chrono::duration<double>(chrono::steady_clock::now() - lastCheckpoint).count() >= checkpointEvery)
+            {
+                writeOutput(checkpointPath);
+                lastCheckpoint = chrono::steady_clock::now();
+            }
         }
+        if (!checkpointPath.empty())
+            writeOutput(checkpointPath);
     }
 
     // ---------------- polygon extraction (unchanged) ----------------
@@ -1671,10 +2105,21 @@ public:
 
     void writeOutput(const string &outFile)
     {
-        ofstream out(outFile);
-        if (!out)
-            throw runtime_error("Cannot write output: " + outFile);
+        const string tmpFile = outFile + ".tmp";
+        {
+            ofstream out(tmpFile);
+            if (!out)
+                throw runtime_error("Cannot write output: " + outFile);
+            writePlacement(out);
+            if (!out.flush())
+                throw runtime_error("Cannot write output: " + outFile);
+        }
+        if (rename(tmpFile.c_str(), outFile.c_str()) != 0)
+            throw runtime_error("Cannot rename " + tmpFile + " to " + outFile);
+    }
 
+    void writePlacement(ostream &out)
+    {
         out << fixed << setprecision(1);
         out << "HPWL " << totalHPWL() << "\n";
 
@@ -1701,20 +2146,49 @@ int main(int argc, char **argv)
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
 
-    if (argc < 4)
+    RefinerPixelEven r;
+    double deadlineSeconds = 0;
+    vector<string> args;
+    for (int i = 1; i < argc; i++)
+    {
+        string a = argv[i];
+        if (a.compare(0, 11, "--deadline=") == 0)
+            deadlineSeconds = atof(a.c_str() + 11);
+        else if (a.compare(0, 13, "--checkpoint=") == 0)
+            r.checkpointPath = a.substr(13);
+        else
+            args.push_back(a);
+    }
+
+    if (args.size() < 3)
     {
-        cerr << "Usage: ./refiner_stage2 <input> <stage1_out> <final_out>\n";
+        cerr << "Usage: ./refiner_stage2 <input> <stage1_out> <final_out> [threads] [--deadline=seconds] [--checkpoint=file]\n";
         return 1;
     }
+    if (deadlineSeconds > 0)
+    {
+        r.hasDeadline = true;
+        r.deadline = chrono::steady_clock::now() +
+                     chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(deadlineSeconds));
+    }
+    signal(SIGTERM, onStopSignal);
+    signal(SIGINT, onStopSignal);
 
     try
     {
-        RefinerPixelEven r;
-        r.parseProblem(argv[1]);
-        r.parseStage1(argv[2]);
+        r.numThreads = (args.size() >= 4) ? max(1, atoi(args[3].c_str()))
+                                          : max(1, (int)thread::hardware_concurrency());
+        r.parseProblem(args[0]);
+        string start = args[1];
+        if (!r.checkpointPath.empty() && ifstream(r.checkpointPath))
+        {
+            start = r.checkpointPath;
+            cout << "Resuming from checkpoint " << start << "\n";
+        }
+        r.parseStage1(start);
         r.buildGridAndFrontiers();
         r.optimize();
-        r.writeOutput(argv[3]);
+        r.writeOutput(args[2]);
     }
     catch (const exception &e)
     {
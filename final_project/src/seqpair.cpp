@@ -0,0 +1,236 @@
+#include "seqpair.h"
+#include "tree.h" // resizeRandomBlock()
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+
+using namespace std;
+
+void SeqPair::setFixedModules(const vector<Block> *fixed, const int *originX, const int *originY)
+{
+    _fixed_modules = fixed;
+    _originX = originX;
+    _originY = originY;
+}
+
+void SeqPair::buildInitial()
+{
+    const int numFixed = _fixed_modules ? (int)_fixed_modules->size() : 0;
+    const int n = numSoft() + numFixed;
+
+    // Soft block i goes to row i / k, column i % k of a k x k grid: X lists
+    // the rows top to bottom, Y bottom to top, both left to right in a row
+    int k = max(1, (int)ceil(sqrt((double)numSoft())));
+    int rows = (numSoft() + k - 1) / k;
+    _seqX.clear();
+    _seqY.clear();
+    for (int r = rows - 1; r >= 0; --r)
+        for (int i = r * k; i < min(numSoft(), (r + 1) * k); ++i)
+            _seqX.push_back(i);
+    for (int i = 0; i < numSoft(); ++i)
+        _seqY.push_back(i);
+
+    // Fixed modules last in both: right of everything, constraining nothing
+    for (int f = 0; f < numFixed; ++f)
+    {
+        _seqX.push_back(numSoft() + f);
+        _seqY.push_back(numSoft() + f);
+    }
+
+    _posX.assign(n, 0);
+    _posY.assign(n, 0);
+    for (int i = 0; i < n; ++i)
+    {
+        _posX[_seqX[i]] = i;
+        _posY[_seqY[i]] = i;
+    }
+    _rotated.assign(n, 0);
+    _undo.clear();
+}
+
+void SeqPair::swapInX(int i, int j)
+{
+    swap(_seqX[i], _seqX[j]);
+    _posX[_seqX[i]] = i;
+    _posX[_seqX[j]] = j;
+}
+
+void SeqPair::swapInY(int i, int j)
+{
+    swap(_seqY[i], _seqY[j]);
+    _posY[_seqY[i]] = i;
+    _posY[_seqY[j]] = j;
+}
+
+void SeqPair::rotateRandom()
+{
+    if (_blocks.empty())
+        return;
+    int e = randIndex(*_rng, numSoft());
+    _rotated[e] = !_rotated[e];
+    _undo.push_back({'r', e, e});
+}
+
+void SeqPair::deleteAndInsert()
+{
+    const int n = numElements();
+    if (n < 2)
+        return;
+    int i = randIndex(*_rng, n);
+    int j = randIndex(*_rng, n - 1);
+    if (j >= i)
+        ++j;
+    if (randIndex(*_rng, 2))
+    {
+        swapInX(i, j);
+        _undo.push_back({'x', i, j});
+    }
+    else
+    {
+        swapInY(i, j);
+        _undo.push_back({'y', i, j});
+    }
+}
+
+void SeqPair::swapRandomNodes()
+{
+    const int n = numElements();
+    if (n < 2)
+        return;
+    int a = randIndex(*_rng, n);
+    int b = randIndex(*_rng, n - 1);
+    if (b >= a)
+        ++b;
+    int i = _posX[a], j = _posX[b];
+    swapInX(i, j);
+    _undo.push_back({'x', i, j});
+    i = _posY[a];
+    j = _posY[b];
+    swapInY(i, j);
+    _undo.push_back({'y', i, j});
+}
+
+ShapeUndo SeqPair::resizeRandom()
+{
+    return resizeRandomBlock(_blocks, *_rng);
+}
+
+void SeqPair::undo()
+{
+    for (auto it = _undo.rbegin(); it != _undo.rend(); ++it)
+    {
+        if (it->kind == 'x')
+            swapInX(it->a, it->b);
+        else if (it->kind == 'y')
+            swapInY(it->a, it->b);
+        else
+            _rotated[it->a] = !_rotated[it->a];
+    }
+    _undo.clear();
+}
+
+// Longest paths in the horizontal (or vertical) constraint graph as a
+// weighted LCS: walk X forwards (backwards for vertical); the elements already
+// seen that precede e in Y are exactly those left of (below) e. _stair keeps,
+// for the Y positions seen so far, the best path end among keys up to there,
+// so the predecessor of e's key answers the query.
+void SeqPair::longestPaths(bool horizontal)
+{
+    const int n = numElements();
+    vector<long long> &coord = horizontal ? _x : _y;
+    coord.resize(n);
+    _stair.clear();
+
+    for (int k = 0; k < n; ++k)
+    {
+        int e = horizontal ? _seqX[k] : _seqX[n - 1 - k];
+        int key = _posY[e];
+
+        auto it = _stair.lower_bound(key);
+        long long start = (it == _stair.begin()) ? 0 : prev(it)->second;
+        long long len;
+        if (e < numSoft())
+        {
+            const Block &blk = _blocks[e];
+            len = horizontal ? blk.getWidth(_rotated[e]) : blk.getHeight(_rotated[e]);
+        }
+        else
+        {
+            // pre-placed: not left of its real position
+            const Block &f = (*_fixed_modules)[e - numSoft()];
+            len = horizontal ? f.getWidth() : f.getHeight();
+            long long target = horizontal ? (long long)f.getX1() - *_originX
+                                          : (long long)f.getY1() - *_originY;
+            start = max(start, target);
+        }
+        coord[e] = start;
+
+        long long end = start + len;
+        it = _stair.insert(it, make_pair(key, end));
+        // drop keys to the right that no longer improve on this one
+        for (auto jt = next(it); jt != _stair.end() && jt->second <= end;)
+            jt = _stair.erase(jt);
+    }
+}
+
+void SeqPair::pack()
+{
+    longestPaths(true);
+    longestPaths(false);
+
+    for (int e = 0; e < numSoft(); ++e)
+    {
+        Block &blk = _blocks[e];
+        size_t x = (size_t)_x[e], y = (size_t)_y[e];
+        blk.setPos(x, y, x + blk.getWidth(_rotated[e]), y + blk.getHeight(_rotated[e]));
+    }
+}
+
+void SeqPair::save(ostream &out) const
+{
+    const int n = numElements();
+    out << n << "\n";
+    for (int i = 0; i < n; ++i)
+        out << _seqX[i] << (i + 1 < n ? " " : "\n");
+    for (int i = 0; i < n; ++i)
+        out << _seqY[i] << (i + 1 < n ? " " : "\n");
+    for (int i = 0; i < n; ++i)
+        out << (_rotated[i] ? 1 : 0) << (i + 1 < n ? " " : "\n");
+}
+
+bool SeqPair::load(istream &in)
+{
+    int n;
+    if (!(in >> n) || n != numElements())
+        return false;
+
+    vector<int> seqX(n), seqY(n), posX(n, -1), posY(n, -1);
+    vector<char> rotated(n);
+    for (int i = 0; i < n; ++i)
+    {
+        if (!(in >> seqX[i]) || seqX[i] < 0 || seqX[i] >= n || posX[seqX[i]] != -1)
+            return false;
+        posX[seqX[i]] = i;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        if (!(in >> seqY[i]) || seqY[i] < 0 || seqY[i] >= n || posY[seqY[i]] != -1)
+            return false;
+        posY[seqY[i]] = i;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        int r;
+        if (!(in >> r) || (r != 0 && i >= numSoft()))
+            return false;
+        rotated[i] = (r != 0);
+    }
+
+    _seqX = seqX;
+    _seqY = seqY;
+    _posX = posX;
+    _posY = posY;
+    _rotated = rotated;
+    _undo.clear();
+    return true;
+}
@@ -0,0 +1,100 @@
+#ifndef SEQPAIR_H
+#define SEQPAIR_H
+
+#include <vector>
+#include <map>
+#include <iostream>
+#include <random>
+#include "module.h" // Block
+
+using namespace std;
+
+// Sequence-pair representation, an alternative to the B*-tree (Tree) behind
+// the same move / pack interface, so Floorplanner can anneal either one.
+//
+// Elements [0, numSoft) are the soft blocks, [numSoft, numSoft + numFixed)
+// the fixed modules. a is left of b when a comes before b in both sequences,
+// and below b when a comes after b in X and before b in Y.
+//
+// pack() evaluates the pair as two weighted longest common subsequences
+// (FAST-SP) with a balanced tree over Y positions: O(n log n). Fixed modules
+// are pre-placed: their coordinate is raised to their real position (relative
+// to the cluster origin), so everything constrained to their right / above
+// them is pushed past them. A fixed module that cannot reach its position is
+// left where the packing puts it and the overlap penalty takes care of it.
+//
+// Every move is a swap of two sequence entries (or a rotation flag) and is
+// logged, so undo() takes the pair back to the last clearUndo() in O(moves).
+// Block shapes (resizeRandom) live in the block array and are restored by
+// the caller from the returned ShapeUndo, as with Tree.
+class SeqPair
+{
+public:
+    SeqPair(vector<Block> &blocks) : _blocks(blocks) {}
+
+    void buildInitial();    // soft blocks on a square grid, fixed modules to the right
+    void rotateRandom();    // perturbation 1
+    void deleteAndInsert(); // perturbation 2: swap two entries of one sequence (topology)
+    void swapRandomNodes(); // perturbation 3: swap two elements in both sequences (position)
+    ShapeUndo resizeRandom(); // perturbation 4 for soft modules
+
+    void pack(); // compute (x1, y1, x2, y2) of each soft block, relative to the origin
+
+    void clearUndo() { _undo.clear(); }
+    void undo(); // revert the moves since clearUndo()
+
+    // Fixed modules and the cluster origin they are pre-placed against
+    void setFixedModules(const vector<Block> *fixed, const int *originX, const int *originY);
+    void setRng(mt19937 *rng) { _rng = rng; } // the moves draw from it
+
+    // checkpointing: both sequences and rotations by element index
+    static const char *checkpointTag() { return "SEQPAIR"; }
+    void save(ostream &out) const;
+    bool load(istream &in); // false (pair unchanged) if it does not fit this problem
+
+    SeqPair(const SeqPair &) = default;
+    SeqPair &operator=(const SeqPair &other)
+    {
+        if (this != &other)
+        {
+            // Reuse the existing _blocks reference and fixed modules
+            _seqX = other._seqX;
+            _seqY = other._seqY;
+            _posX = other._posX;
+            _posY = other._posY;
+            _rotated = other._rotated;
+            _undo.clear();
+        }
+        return *this;
+    }
+
+private:
+    struct Move
+    {
+        char kind; // 'x' / 'y': swap of two sequence positions, 'r': rotation of element a
+        int a, b;
+    };
+
+    vector<Block> &_blocks; // Reference to external (soft) block array
+    const vector<Block> *_fixed_modules = nullptr;
+    const int *_originX = nullptr;
+    const int *_originY = nullptr;
+    mt19937 *_rng = nullptr;
+
+    vector<int> _seqX, _seqY;  // the pair, as element indices
+    vector<int> _posX, _posY;  // element -> position in each sequence
+    vector<char> _rotated;     // by element (fixed modules never rotate)
+    vector<Move> _undo;
+
+    // pack scratch
+    vector<long long> _x, _y;
+    map<int, long long> _stair; // Y position -> longest path ending there (increasing)
+
+    int numElements() const { return (int)_seqX.size(); }
+    int numSoft() const { return (int)_blocks.size(); }
+    void swapInX(int i, int j);
+    void swapInY(int i, int j);
+    void longestPaths(bool horizontal);
+};
+
+#endif // SEQPAIR_H
@@ -94,25 +94,35 @@ using namespace std;
 //     _blocks[randIdx].resize(ar);
 // }
 
-void Tree::resizeRandom()
+ShapeUndo Tree::resizeRandom()
 {
-    if (_blocks.empty())
-        return;
+    return resizeRandomBlock(_blocks, *_rng);
+}
 
-    int randIdx = rand() % _blocks.size();
+// Shared with SeqPair: reshape one random soft block (ghosts may vanish)
+ShapeUndo resizeRandomBlock(vector<Block> &blocks, mt19937 &rng)
+{
+    ShapeUndo undo;
+    if (blocks.empty())
+        return undo;
+
+    int randIdx = randIndex(rng, blocks.size());
 
     // Skip fixed blocks
-    if (_blocks[randIdx].isFixed())
-        return;
+    if (blocks[randIdx].isFixed())
+        return undo;
 
-    Block &blk = _blocks[randIdx];
+    Block &blk = blocks[randIdx];
+    undo.index = randIdx;
+    undo.w = blk.getWidth();
+    undo.h = blk.getHeight();
 
     // LOGIC FOR GHOST BLOCKS
     if (blk.isGhost())
     {
         // 50% chance to become ACTIVE (Spacer)
         // 50% chance to become INACTIVE (Zero Size)
-        double choice = (double)rand() / RAND_MAX;
+        double choice = randUnit(rng);
 
         if (choice < 0.5)
         {
@@ -124,7 +134,7 @@ void Tree::resizeRandom()
         {
             // BECOME ACTIVE (restore/resize)
             // Generate a random skinny/flat aspect ratio
-            double ar = 0.1 + ((double)rand() / RAND_MAX) * 9.9;
+            double ar = 0.1 + randUnit(rng) * 9.9;
 
             // This function uses _minArea to recalculate Width and Height
             // effectively "Resurrecting" the ghost if it was previously 0
@@ -135,9 +145,10 @@ void Tree::resizeRandom()
     else
     {
         // Standard aspect ratio resize (0.5 to 2.0)
-        double ar = 0.5 + ((double)rand() / RAND_MAX) * 1.5;
+        double ar = 0.5 + randUnit(rng) * 1.5;
         blk.resize(ar);
     }
+    return undo;
 }
 
 void Tree::buildInitial()
@@ -216,13 +227,77 @@ void Tree::buildInitial()
 //     return root;
 // }
 
+// Checkpoint format: "<numNodes> <root>", then one "<rotated> <left> <right>"
+// line per node in block order (-1 = no child)
+void Tree::save(ostream &out) const
+{
+    out << _nodes.size() << " " << (_root ? _root->getBlockIndex() : -1) << "\n";
+    for (const Node &v : _nodes)
+    {
+        out << (v.isRotated() ? 1 : 0) << " "
+            << (v.getLeft() ? v.getLeft()->getBlockIndex() : -1) << " "
+            << (v.getRight() ? v.getRight()->getBlockIndex() : -1) << "\n";
+    }
+}
+
+bool Tree::load(istream &in)
+{
+    size_t n;
+    int root;
+    if (!(in >> n >> root) || n != _nodes.size() || root < 0 || root >= (int)n)
+        return false;
+
+    vector<int> rotated(n), left(n), right(n), parent(n, -1);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (!(in >> rotated[i] >> left[i] >> right[i]))
+            return false;
+        for (int c : {left[i], right[i]})
+        {
+            if (c < -1 || c >= (int)n || c == root)
+                return false;
+            if (c >= 0)
+            {
+                if (parent[c] != -1)
+                    return false; // two parents
+                parent[c] = (int)i;
+            }
+        }
+    }
+    // every node must hang off the root (no cycles, no strays)
+    size_t reached = 0;
+    vector<int> stack(1, root);
+    while (!stack.empty() && reached <= n)
+    {
+        int v = stack.back();
+        stack.pop_back();
+        ++reached;
+        if (left[v] >= 0)
+            stack.push_back(left[v]);
+        if (right[v] >= 0)
+            stack.push_back(right[v]);
+    }
+    if (reached != n)
+        return false;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        _nodes[i].setRotated(rotated[i] != 0);
+        _nodes[i].setParent(parent[i] >= 0 ? &_nodes[parent[i]] : nullptr);
+        _nodes[i].setLeft(left[i] >= 0 ? &_nodes[left[i]] : nullptr);
+        _nodes[i].setRight(right[i] >= 0 ? &_nodes[right[i]] : nullptr);
+    }
+    _root = &_nodes[root];
+    return true;
+}
+
 void Tree::rotateRandom()
 {
     // Randomly rotate a node in the tree
     if (_nodes.empty())
         return;
     // Select a random node index
-    size_t randomIndex = rand() % _nodes.size();
+    size_t randomIndex = randIndex(*_rng, _nodes.size());
     Node *randomNode = &_nodes[randomIndex];
 
     // Toggle rotation state
@@ -402,7 +477,7 @@ void Tree::deleteAndInsert()
     // do {
     //     u = &_nodes[rand() % _nodes.size()];
     // } while (u == _root);  // Avoid deleting root for now
-    u = &_nodes[rand() % _nodes.size()];
+    u = &_nodes[randIndex(*_rng, _nodes.size())];
 
     deleteNode(u);
 
@@ -420,12 +495,12 @@ void Tree::deleteAndInsert()
         return; // No valid place to reinsert
 
     // Step 3: pick one and insert u as child
-    Node *target = candidates[rand() % candidates.size()];
+    Node *target = candidates[randIndex(*_rng, candidates.size())];
     bool asLeft;
     if (target->getLeft() == nullptr && target->getRight() == nullptr)
     {
         // both available — pick randomly
-        asLeft = rand() % 2;
+        asLeft = randIndex(*_rng, 2);
         // asLeft = true;
     }
     else if (target->getLeft() == nullptr)
@@ -553,8 +628,8 @@ void Tree::swapRandomNodes()
 
     do
     {
-        u = &_nodes[rand() % _nodes.size()];
-        v = &_nodes[rand() % _nodes.size()];
+        u = &_nodes[randIndex(*_rng, _nodes.size())];
+        v = &_nodes[randIndex(*_rng, _nodes.size())];
     } while (u == v); // allow root swap if you handle _root properly
 
     //////////////// handle special cases
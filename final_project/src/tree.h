@@ -2,13 +2,22 @@
 #define TREE_H
 
 #include <vector>
-#include <cstdlib> // for rand()
+#include <iostream>
+#include <random>
 #include "node.h"
 #include "module.h" // Block, Terminal, Net
 #include <chrono>
 
 using namespace std;
 
+// One resize move on a random soft block (used by Tree and SeqPair)
+ShapeUndo resizeRandomBlock(vector<Block> &blocks, mt19937 &rng);
+
+// Draws for the moves. Each Floorplanner owns its generator, so replicas
+// annealing on different threads never share rand()'s state.
+inline int randIndex(mt19937 &rng, size_t n) { return (int)uniform_int_distribution<size_t>(0, n - 1)(rng); } // [0, n)
+inline double randUnit(mt19937 &rng) { return uniform_real_distribution<double>(0.0, 1.0)(rng); }          // [0, 1)
+
 class Tree
 {
 public:
@@ -25,7 +34,7 @@ public:
     void rotateRandom();                                // perturbation 1
     void deleteAndInsert();                             // perturbation 2
     void swapRandomNodes();                             // perturbation 3
-    void resizeRandom();                                // perturbation 4 for soft modules
+    ShapeUndo resizeRandom();                           // perturbation 4 for soft modules
     bool isDescendant(Node *ancestor, Node *candidate); // check if candidate is a descendant of ancestor
     Node *buildBalancedRecursive(int l, int r);         // build a balanced tree recursively
 
@@ -37,6 +46,11 @@ public:
     void printContour() const;                               // print the contour for debugging
     void checkContour() const;                               // check the contour for debugging
 
+    // checkpointing: tree shape and rotations by block index
+    static const char *checkpointTag() { return "TREE"; }
+    void save(ostream &out) const;
+    bool load(istream &in); // false (tree unchanged) if it does not fit this tree
+
     Node *getRoot() const { return _root; }
     const vector<Node> &getNodes() const { return _nodes; }
 
@@ -48,6 +62,7 @@ public:
     {
         _fixed_modules = fixed;
     }
+    void setRng(mt19937 *rng) { _rng = rng; } // the moves draw from it
 
     // horizontal segment of the contour
     struct ContourSegment
@@ -67,6 +82,14 @@ public:
     void exportToFile(fstream &output, size_t outlineW, size_t outlineH, const std::chrono::milliseconds &duration, size_t outputCost, size_t outputWL, size_t outputArea, size_t maxX, size_t maxY) const;
     void exportToFile_visualize(fstream &output, size_t outlineW, size_t outlineH, const std::chrono::milliseconds &duration, size_t outputCost, size_t outputWL, size_t outputArea, size_t maxX, size_t maxY) const;
 
+    // A copy links its nodes among themselves, not into other's (see operator=)
+    Tree(const Tree &other)
+        : _root(nullptr), _blocks(other._blocks), _contourHead(nullptr),
+          _fixed_modules(other._fixed_modules), _rng(other._rng)
+    {
+        *this = other;
+    }
+
     Tree &operator=(const Tree &other)
     {
         if (this != &other)
@@ -105,6 +128,7 @@ private:
 
     ContourSegment *_contourHead; // head of the contour list
     const vector<Block> *_fixed_modules = nullptr;
+    mt19937 *_rng = nullptr;
 };
 
 #endif // TREE_H
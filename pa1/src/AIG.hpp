@@ -0,0 +1,411 @@
+#pragma once
+#include "CNF.hpp"
+#include "BenchParser.hpp"
+#include "Tseitin.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// And-inverter graph shared by both circuits of the miter.
+//
+// A literal is 2 * node + complement; node 0 is constant FALSE (literal 0,
+// literal 1 is TRUE). Nodes are primary inputs or 2-input ANDs and are
+// created fanins first, so node order is a topological order. mk_and()
+// folds constants and trivial cases and hashes every AND by its (sorted)
+// fanins, so structurally identical logic - within a circuit or across the
+// two - becomes the same node.
+struct AIG
+{
+    vector<int> fanin0, fanin1; // per node; -1 for the constant and PIs
+    vector<string_view> pi_names;       // PI nodes by name, in creation order
+    vector<char> pi_shared;             // 0: free net of one circuit, not a real PI
+    unordered_map<string_view, int> pi; // name -> PI literal (shared by both circuits)
+
+    AIG()
+    {
+        fanin0.push_back(-1); // node 0: constant
+        fanin1.push_back(-1);
+        table_.assign(1024, 0);
+    }
+
+    static int lit_not(int a) { return a ^ 1; }
+    static int lit_node(int a) { return a >> 1; }
+    static bool lit_compl(int a) { return a & 1; }
+
+    size_t num_nodes() const { return fanin0.size(); }
+    bool is_pi(int node) const { return node > 0 && fanin0[node] < 0; }
+    bool is_and(int node) const { return fanin0[node] >= 0; }
+    size_t num_ands() const { return num_nodes() - 1 - pi_names.size(); }
+
+    int mk_pi(string_view name)
+    {
+        auto it = pi.find(name);
+        if (it != pi.end())
+            return it->second;
+        int lit = mk_free(name);
+        pi_shared.back() = 1;
+        pi.emplace(name, lit);
+        return lit;
+    }
+
+    // An input that is not shared by name (a net nothing drives)
+    int mk_free(string_view name)
+    {
+        int lit = 2 * (int)num_nodes();
+        fanin0.push_back(-1);
+        fanin1.push_back(-1);
+        pi_names.push_back(name);
+        pi_shared.push_back(0);
+        return lit;
+    }
+
+    int mk_and(int a, int b)
+    {
+        if (a > b)
+            swap(a, b);
+        if (a == 0 || a == lit_not(b))
+            return 0; // FALSE
+        if (a == 1 || a == b)
+            return b;
+
+        if (2 * (num_ands() + 1) > table_.size())
+            grow();
+        size_t mask = table_.size() - 1;
+        for (size_t i = hash_pair(a, b) & mask;; i = (i + 1) & mask)
+        {
+            int n = table_[i];
+            if (n == 0)
+            {
+                n = (int)num_nodes();
+                fanin0.push_back(a);
+                fanin1.push_back(b);
+                table_[i] = n;
+                return 2 * n;
+            }
+            if (fanin0[n] == a && fanin1[n] == b)
+                return 2 * n;
+        }
+    }
+    int mk_or(int a, int b) { return lit_not(mk_and(lit_not(a), lit_not(b))); }
+    int mk_xor(int a, int b) { return mk_or(mk_and(a, lit_not(b)), mk_and(lit_not(a), b)); }
+
+    // n-ary AND over sorted operands, so the input order of a gate does not
+    // change the nodes it hashes to
+    int mk_and_n(vector<int> &lits)
+    {
+        sort(lits.begin(), lits.end());
+        int r = 1;
+        for (int l : lits)
+            r = mk_and(r, l);
+        return r;
+    }
+
+    // Add one circuit (gates in topological order); returns its PO literals
+    // in the order of ckt.outputs
+    vector<int> add_circuit(const Circuit &ckt)
+    {
+        vector<int> lit(ckt.num_nets(), -1);
+        for (int x : ckt.inputs)
+            lit[x] = mk_pi(ckt.names[x]);
+        auto net_lit = [&](int n)
+        {
+            if (lit[n] < 0) // undriven net: a free input of this circuit only
+                lit[n] = mk_free(ckt.names[n]);
+            return lit[n];
+        };
+
+        vector<int> xs;
+        for (int gi : ckt.topo)
+        {
+            const Gate &g = ckt.gates[gi];
+            xs.clear();
+            for (const int *p = ckt.ins_begin(g); p != ckt.ins_end(g); ++p)
+                xs.push_back(net_lit(*p));
+
+            int z = 0;
+            switch (g.type)
+            {
+            case GateType::BUFF:
+                z = xs[0];
+                break;
+            case GateType::NOT:
+                z = lit_not(xs[0]);
+                break;
+            case GateType::AND:
+            case GateType::NAND:
+                z = mk_and_n(xs);
+                break;
+            case GateType::OR:
+            case GateType::NOR:
+                for (int &x : xs)
+                    x = lit_not(x);
+                z = lit_not(mk_and_n(xs));
+                break;
+            case GateType::XOR:
+                z = xs[0];
+                for (size_t k = 1; k < xs.size(); ++k)
+                    z = mk_xor(z, xs[k]);
+                break;
+            }
+            if (g.type == GateType::NAND || g.type == GateType::NOR)
+                z = lit_not(z);
+            lit[g.out] = z;
+        }
+
+        vector<int> outs;
+        outs.reserve(ckt.outputs.size());
+        for (int o : ckt.outputs)
+            outs.push_back(net_lit(o));
+        return outs;
+    }
+
+private:
+    vector<int> table_; // open addressing over AND nodes, 0 = empty
+
+    static size_t hash_pair(int a, int b)
+    {
+        uint64_t k = ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        return (size_t)k;
+    }
+
+    void grow()
+    {
+        table_.assign(2 * table_.size(), 0);
+        size_t mask = table_.size() - 1;
+        for (int n = 1; n < (int)num_nodes(); ++n)
+        {
+            if (!is_and(n))
+                continue;
+            size_t i = hash_pair(fanin0[n], fanin1[n]) & mask;
+            while (table_[i] != 0)
+                i = (i + 1) & mask;
+            table_[i] = n;
+        }
+    }
+};
+
+inline vector<int> encode_aig_to_cnf_pg(CNF &cnf, PinTable &pt, const AIG &aig, const vector<int> &roots);
+
+// Tseitin-encode the cones of the given AIG literals (and nothing else) with
+// enc_AND. PIs get their variables through pt, so they are shared with
+// anything else encoded against the same PinTable. Returns the CNF literal
+// of each root. With pg, see encode_aig_to_cnf_pg.
+inline vector<int> encode_aig_to_cnf(CNF &cnf, PinTable &pt, const AIG &aig, const vector<int> &roots,
+                                     bool pg = false)
+{
+    if (pg)
+        return encode_aig_to_cnf_pg(cnf, pt, aig, roots);
+    const int numNodes = (int)aig.num_nodes();
+    vector<char> need(numNodes, 0);
+    for (int r : roots)
+        need[AIG::lit_node(r)] = 1;
+    for (int n = numNodes - 1; n > 0; --n)
+    {
+        if (need[n] && aig.is_and(n))
+        {
+            need[AIG::lit_node(aig.fanin0[n])] = 1;
+            need[AIG::lit_node(aig.fanin1[n])] = 1;
+        }
+    }
+
+    vector<int> var(numNodes, 0);
+    if (need[0])
+    {
+        var[0] = cnf.new_var();
+        cnf.add_clause({-var[0]}); // constant FALSE
+    }
+    auto cnf_lit = [&](int lit)
+    {
+        int v = var[AIG::lit_node(lit)];
+        return AIG::lit_compl(lit) ? -v : v;
+    };
+
+    vector<int> xs(2);
+    size_t nextPi = 0;
+    for (int n = 1; n < numNodes; ++n)
+    {
+        if (aig.is_pi(n))
+        {
+            // PI nodes are numbered in pi_names order
+            size_t k = nextPi++;
+            if (need[n])
+                var[n] = aig.pi_shared[k] ? pt.get_or_create_pi(cnf, aig.pi_names[k]) : cnf.new_var();
+            continue;
+        }
+        if (!need[n])
+            continue;
+        var[n] = cnf.new_var();
+        xs[0] = cnf_lit(aig.fanin0[n]);
+        xs[1] = cnf_lit(aig.fanin1[n]);
+        enc_AND(cnf, var[n], xs);
+    }
+
+    vector<int> out;
+    out.reserve(roots.size());
+    for (int r : roots)
+        out.push_back(cnf_lit(r));
+    return out;
+}
+
+// The XOR pattern AND(!AND(u, v), !AND(!u, !v)) = u XOR v, with both inner
+// ANDs used nowhere else (refs: per node, its number of fanouts)
+inline bool aig_xor_pattern(const AIG &aig, const vector<int> &refs, int n, int &u, int &v)
+{
+    int f0 = aig.fanin0[n], f1 = aig.fanin1[n];
+    if (!aig.is_and(n) || !AIG::lit_compl(f0) || !AIG::lit_compl(f1))
+        return false;
+    int p = AIG::lit_node(f0), q = AIG::lit_node(f1);
+    if (!aig.is_and(p) || !aig.is_and(q) || refs[p] != 1 || refs[q] != 1)
+        return false;
+    // fanins are sorted, and complementing both keeps their order
+    if (aig.fanin0[q] != AIG::lit_not(aig.fanin0[p]) || aig.fanin1[q] != AIG::lit_not(aig.fanin1[p]))
+        return false;
+    u = aig.fanin0[p];
+    v = aig.fanin1[p];
+    return true;
+}
+
+// Plaisted-Greenbaum encoding of the cones of the given AIG literals.
+//
+// Trees of single-fanout ANDs become one wide AND, and XOR patterns (chained
+// up to kXorWidth inputs) one wide XOR; only their roots get variables. Each
+// gate is then encoded in just the polarity it is needed in, from the roots
+// (needed both ways) down: an AND passes its polarity to its inputs, flipped
+// through complemented edges, an XOR needs its inputs both ways. PIs, the
+// PinTable and the result are as in encode_aig_to_cnf.
+inline vector<int> encode_aig_to_cnf_pg(CNF &cnf, PinTable &pt, const AIG &aig, const vector<int> &roots)
+{
+    const int numNodes = (int)aig.num_nodes();
+    vector<char> need(numNodes, 0);
+    vector<int> refs(numNodes, 0);
+    for (int r : roots)
+    {
+        need[AIG::lit_node(r)] = 1;
+        ++refs[AIG::lit_node(r)]; // a root always keeps its own variable
+    }
+    for (int n = numNodes - 1; n > 0; --n)
+    {
+        if (need[n] && aig.is_and(n))
+        {
+            need[AIG::lit_node(aig.fanin0[n])] = need[AIG::lit_node(aig.fanin1[n])] = 1;
+            ++refs[AIG::lit_node(aig.fanin0[n])];
+            ++refs[AIG::lit_node(aig.fanin1[n])];
+        }
+    }
+
+    // Top down: collect each gate's inputs (leaves) and push its polarity
+    // to the gates among them
+    struct WideGate
+    {
+        int beg = 0, len = 0; // into leaves (AIG literals)
+        bool isXor = false;
+    };
+    vector<WideGate> gate(numNodes);
+    vector<char> pol(numNodes, POL_NONE); // POL_NONE: no gate of its own
+    vector<int> leaves, work;
+    for (int r : roots)
+        pol[AIG::lit_node(r)] = POL_BOTH;
+    for (int n = numNodes - 1; n > 0; --n)
+    {
+        if (!pol[n] || !aig.is_and(n))
+            continue;
+        WideGate &g = gate[n];
+        g.beg = (int)leaves.size();
+        int u, v;
+        if (aig_xor_pattern(aig, refs, n, u, v))
+        {
+            g.isXor = true;
+            bool parity = false;
+            work.assign({v, u});
+            while (!work.empty())
+            {
+                int l = work.back(), k = AIG::lit_node(l);
+                work.pop_back();
+                // an inner XOR is referenced just by its parent's two ANDs
+                size_t width = leaves.size() - g.beg + work.size() + 2;
+                if (refs[k] == 2 && width <= kXorWidth && aig_xor_pattern(aig, refs, k, u, v))
+                {
+                    parity ^= AIG::lit_compl(l);
+                    work.push_back(v);
+                    work.push_back(u);
+                    continue;
+                }
+                leaves.push_back(l);
+            }
+            if (parity)
+                leaves[g.beg] = AIG::lit_not(leaves[g.beg]);
+        }
+        else
+        {
+            work.assign({aig.fanin1[n], aig.fanin0[n]});
+            while (!work.empty())
+            {
+                int l = work.back(), k = AIG::lit_node(l), u2, v2;
+                work.pop_back();
+                if (!AIG::lit_compl(l) && aig.is_and(k) && refs[k] == 1 && !aig_xor_pattern(aig, refs, k, u2, v2))
+                {
+                    work.push_back(aig.fanin1[k]);
+                    work.push_back(aig.fanin0[k]);
+                    continue;
+                }
+                leaves.push_back(l);
+            }
+        }
+        g.len = (int)leaves.size() - g.beg;
+
+        for (int i = g.beg; i < g.beg + g.len; ++i)
+        {
+            int l = leaves[i];
+            char p = g.isXor ? POL_BOTH : AIG::lit_compl(l) ? flip(pol[n]) : pol[n];
+            pol[AIG::lit_node(l)] |= p;
+        }
+    }
+
+    vector<int> var(numNodes, 0);
+    if (need[0])
+    {
+        var[0] = cnf.new_var();
+        cnf.add_clause({-var[0]}); // constant FALSE
+    }
+    auto cnf_lit = [&](int lit)
+    {
+        int v = var[AIG::lit_node(lit)];
+        return AIG::lit_compl(lit) ? -v : v;
+    };
+
+    vector<int> xs;
+    size_t nextPi = 0;
+    for (int n = 1; n < numNodes; ++n)
+    {
+        if (aig.is_pi(n))
+        {
+            size_t k = nextPi++;
+            if (need[n])
+                var[n] = aig.pi_shared[k] ? pt.get_or_create_pi(cnf, aig.pi_names[k]) : cnf.new_var();
+            continue;
+        }
+        if (!pol[n])
+            continue;
+        var[n] = cnf.new_var();
+        const WideGate &g = gate[n];
+        xs.clear();
+        for (int i = g.beg; i < g.beg + g.len; ++i)
+            xs.push_back(cnf_lit(leaves[i]));
+        if (g.isXor)
+            enc_XOR(cnf, var[n], xs, pol[n]);
+        else
+            enc_AND(cnf, var[n], xs, pol[n]);
+    }
+
+    vector<int> out;
+    out.reserve(roots.size());
+    for (int r : roots)
+        out.push_back(cnf_lit(r));
+    return out;
+}
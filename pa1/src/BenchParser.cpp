@@ -1,177 +1,434 @@
 #include "BenchParser.hpp"
 
-#include <fstream>
-#include <sstream>
-#include <regex>
 #include <algorithm>
 #include <iostream>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
 namespace
 {
-    // Supported gate set (uppercase)
-    static const unordered_set<string> kSupported{
+    // Supported gate set (uppercase), indexed by GateType
+    static const char *const kSupported[] = {
         "AND", "NAND", "OR", "NOR", "NOT", "XOR", "BUFF"};
 
-    inline string trim(string s)
+    // Whole file, mmap'd when possible (read into a buffer otherwise, e.g. a pipe)
+    class MappedFile
     {
-        auto notspace = [](int ch)
-        { return !isspace(ch); };
-        s.erase(s.begin(), find_if(s.begin(), s.end(), notspace));
-        s.erase(find_if(s.rbegin(), s.rend(), notspace).base(), s.end());
-        return s;
+    public:
+        explicit MappedFile(const string &path)
+        {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw BenchParserError("Cannot open .bench file: " + path);
+            struct stat st;
+            if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+            {
+                void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED)
+                {
+                    madvise(p, st.st_size, MADV_SEQUENTIAL);
+                    map_ = p;
+                    size_ = st.st_size;
+                }
+            }
+            if (!map_)
+            {
+                char chunk[1 << 16];
+                ssize_t n;
+                while ((n = read(fd, chunk, sizeof chunk)) > 0)
+                    buf_.append(chunk, n);
+            }
+            close(fd);
+        }
+        ~MappedFile()
+        {
+            if (map_)
+                munmap(map_, size_);
+        }
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        string_view view() const
+        {
+            return map_ ? string_view(static_cast<const char *>(map_), size_) : string_view(buf_);
+        }
+
+    private:
+        void *map_ = nullptr;
+        size_t size_ = 0;
+        string buf_;
+    };
+
+    inline bool is_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
     }
 
-    inline string to_upper(string s)
+    inline string_view trim(string_view s)
     {
-        transform(s.begin(), s.end(), s.begin(),
-                  [](unsigned char c)
-                  { return toupper(c); });
+        while (!s.empty() && is_space(s.front()))
+            s.remove_prefix(1);
+        while (!s.empty() && is_space(s.back()))
+            s.remove_suffix(1);
         return s;
     }
 
+    inline char upper(char c)
+    {
+        return (c >= 'a' && c <= 'z') ? char(c - 'a' + 'A') : c;
+    }
+
+    inline bool iequals(string_view s, const char *word)
+    {
+        size_t i = 0;
+        for (; i < s.size() && word[i]; ++i)
+            if (upper(s[i]) != word[i])
+                return false;
+        return i == s.size() && !word[i];
+    }
+
+    // Characters allowed in a gate output name
+    inline bool is_name_char(char c)
+    {
+        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+               c == '_' || c == ' ' || c == '.' || c == '[' || c == ']' || c == '-';
+    }
+
     // Remove //... or #... comments
-    inline string strip_comment(const string &line)
+    inline string_view strip_comment(string_view line)
     {
-        size_t p1 = line.find("//");
-        size_t p2 = line.find('#');
-        size_t p = min(p1 == string::npos ? line.size() : p1,
-                       p2 == string::npos ? line.size() : p2);
-        return line.substr(0, p);
+        for (size_t i = 0; i < line.size(); ++i)
+        {
+            if (line[i] == '#' || (line[i] == '/' && i + 1 < line.size() && line[i + 1] == '/'))
+                return line.substr(0, i);
+        }
+        return line;
     }
 
-    // Split by comma, trim tokens, drop empties
-    vector<string> split_csv(string s)
+    // Split by comma, trim tokens, drop empties, append to out
+    size_t split_csv(string_view s, vector<string_view> &out)
     {
-        vector<string> out;
-        string tok;
-        istringstream iss(s);
-        while (getline(iss, tok, ','))
+        size_t before = out.size();
+        while (true)
         {
-            tok = trim(tok);
+            size_t comma = s.find(',');
+            string_view tok = trim(s.substr(0, comma));
             if (!tok.empty())
                 out.push_back(tok);
+            if (comma == string_view::npos)
+                break;
+            s.remove_prefix(comma + 1);
         }
-        return out;
+        return out.size() - before;
     }
 
-    // Dedup while preserving order
-    vector<string> dedup_preserve(const vector<string> &v)
+    // "(args)" with nothing but whitespace after it; args (untrimmed) in 'args'
+    bool parse_parens(string_view rest, string_view &args)
     {
-        vector<string> out;
-        unordered_set<string> seen;
-        out.reserve(v.size());
-        for (const auto &x : v)
+        rest = trim(rest);
+        if (rest.empty() || rest.front() != '(')
+            return false;
+        size_t close = rest.find(')');
+        if (close == string_view::npos || close == 1 || !trim(rest.substr(close + 1)).empty())
+            return false;
+        args = rest.substr(1, close - 1);
+        return true;
+    }
+}
+
+const char *gate_type_name(GateType t)
+{
+    return kSupported[static_cast<int>(t)];
+}
+
+namespace
+{
+    // Dedup net ids while preserving order
+    void dedup_preserve(vector<int> &v, size_t numNets)
+    {
+        vector<char> seen(numNets, 0);
+        size_t n = 0;
+        for (int x : v)
         {
-            if (!seen.count(x))
+            if (!seen[x])
             {
-                seen.insert(x);
-                out.push_back(x);
+                seen[x] = 1;
+                v[n++] = x;
+            }
+        }
+        v.resize(n);
+    }
+
+    // Open-addressing name -> net id table (ids index into 'names')
+    class NameTable
+    {
+    public:
+        explicit NameTable(size_t expected)
+        {
+            size_t cap = 16;
+            while (cap < 2 * expected)
+                cap *= 2;
+            slots_.assign(cap, Slot{0, -1});
+        }
+
+        // Existing id of name, or the next id after appending it to names
+        int intern(string_view name, vector<string_view> &names)
+        {
+            if (2 * (names.size() + 1) > slots_.size())
+                grow();
+            uint32_t h = (uint32_t)hash<string_view>()(name);
+            size_t mask = slots_.size() - 1;
+            for (size_t i = h & mask;; i = (i + 1) & mask)
+            {
+                Slot &s = slots_[i];
+                if (s.id < 0)
+                {
+                    s = Slot{h, (int)names.size()};
+                    names.push_back(name);
+                    return s.id;
+                }
+                if (s.hash == h && names[s.id] == name)
+                    return s.id;
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            uint32_t hash;
+            int id; // -1: empty
+        };
+        vector<Slot> slots_;
+
+        void grow()
+        {
+            vector<Slot> old(2 * slots_.size(), Slot{0, -1});
+            old.swap(slots_);
+            size_t mask = slots_.size() - 1;
+            for (const Slot &s : old)
+            {
+                if (s.id < 0)
+                    continue;
+                size_t i = s.hash & mask;
+                while (slots_[i].id >= 0)
+                    i = (i + 1) & mask;
+                slots_[i] = s;
+            }
+        }
+    };
+
+    // Kahn's algorithm over the gates; fails on a combinational loop
+    void build_topo(Circuit &ckt)
+    {
+        const size_t numNets = ckt.num_nets();
+        const size_t numGates = ckt.gates.size();
+
+        // net -> gates reading it (CSR)
+        vector<unsigned> userBegin(numNets + 1, 0);
+        for (int x : ckt.fanin)
+            ++userBegin[x + 1];
+        for (size_t i = 0; i < numNets; ++i)
+            userBegin[i + 1] += userBegin[i];
+        vector<int> users(ckt.fanin.size());
+        vector<unsigned> fill(userBegin.begin(), userBegin.end() - 1);
+
+        vector<int> pending(numGates, 0);
+        for (size_t g = 0; g < numGates; ++g)
+        {
+            for (const int *p = ckt.ins_begin(ckt.gates[g]); p != ckt.ins_end(ckt.gates[g]); ++p)
+            {
+                users[fill[*p]++] = (int)g;
+                if (ckt.driver[*p] >= 0)
+                    ++pending[g];
+            }
+        }
+
+        ckt.topo.clear();
+        ckt.topo.reserve(numGates);
+        for (size_t g = 0; g < numGates; ++g)
+        {
+            if (pending[g] == 0)
+                ckt.topo.push_back((int)g);
+        }
+        for (size_t head = 0; head < ckt.topo.size(); ++head)
+        {
+            int net = ckt.gates[ckt.topo[head]].out;
+            for (unsigned u = userBegin[net]; u < userBegin[net + 1]; ++u)
+            {
+                if (--pending[users[u]] == 0)
+                    ckt.topo.push_back(users[u]);
+            }
+        }
+
+        if (ckt.topo.size() != numGates)
+        {
+            for (size_t g = 0; g < numGates; ++g)
+            {
+                if (pending[g] > 0)
+                    throw BenchParserError("Combinational loop through net '" +
+                                           string(ckt.names[ckt.gates[g].out]) + "'");
             }
         }
-        return out;
     }
 }
 
+// Single pass over the file, one line at a time. A line is either
+//   INPUT(a, b, ...) / OUTPUT(...)        (keyword case-insensitive)
+//   out = TYPE(in1, in2, ...)
+// after // and # comments are removed. Names are interned as they are met;
+// nothing is copied (names are views into the file, which the returned
+// Circuit holds on to).
 Circuit parse_bench(const string &path)
 {
-    ifstream fin(path);
-    if (!fin)
-        throw BenchParserError("Cannot open .bench file: " + path);
-
-    regex io_re(R"(^(INPUT|OUTPUT)\s*\(\s*([^)]+?)\s*\)\s*$)", regex::icase);
-    regex gate_re(
-        R"(^\s*([A-Za-z0-9_ \.\[\]\-]+?)\s*=\s*([A-Za-z]+)\s*\(\s*([^)]+?)\s*\)\s*$)");
+    auto file = make_shared<const MappedFile>(path);
+    string_view text = file->view();
 
     Circuit ckt;
-    string raw;
+    ckt.text = file;
+    const size_t numLines = count(text.begin(), text.end(), '\n') + 1;
+    ckt.gates.reserve(numLines); // at most one gate per line
+
+    NameTable ids(numLines);
+    auto intern = [&](string_view name) -> int
+    {
+        int id = ids.intern(name, ckt.names);
+        if (id == (int)ckt.driver.size())
+            ckt.driver.push_back(-1);
+        return id;
+    };
+
+    vector<string_view> tokens;
     size_t lineno = 0;
 
-    while (getline(fin, raw))
+    while (!text.empty())
     {
         ++lineno;
-        string line = trim(strip_comment(raw));
+        size_t eol = text.find('\n');
+        string_view raw = text.substr(0, eol);
+        text.remove_prefix(eol == string_view::npos ? text.size() : eol + 1);
+
+        string_view line = trim(strip_comment(raw));
         if (line.empty())
             continue;
 
-        smatch m;
+        auto unrecognized = [&]()
+        {
+            return BenchParserError("Unrecognized .bench line at " + to_string(lineno) + ": " + string(line));
+        };
+
+        size_t sep = line.find_first_of("(=");
+        if (sep == string_view::npos)
+            throw unrecognized();
+
+        tokens.clear();
 
         // Try INPUT/OUTPUT
-        if (regex_match(line, m, io_re))
+        if (line[sep] == '(')
         {
-            string kind = to_upper(m[1].str());
-            string name = trim(m[2].str());
-            auto names = split_csv(name);
-            if (names.empty())
-            {
-                throw BenchParserError("Empty name in " + kind + " at line " + to_string(lineno));
-            }
-            if (kind == "INPUT")
-            {
-                ckt.inputs.insert(ckt.inputs.end(), names.begin(), names.end());
-            }
-            else
+            string_view kw = trim(line.substr(0, sep));
+            bool isInput = iequals(kw, "INPUT");
+            string_view args;
+            if ((!isInput && !iequals(kw, "OUTPUT")) || !parse_parens(line.substr(sep), args))
+                throw unrecognized();
+
+            if (split_csv(args, tokens) == 0)
             {
-                ckt.outputs.insert(ckt.outputs.end(), names.begin(), names.end());
+                throw BenchParserError(string("Empty name in ") + (isInput ? "INPUT" : "OUTPUT") +
+                                       " at line " + to_string(lineno));
             }
+            vector<int> &dst = isInput ? ckt.inputs : ckt.outputs;
+            for (string_view name : tokens)
+                dst.push_back(intern(name));
             continue;
         }
 
         // Try gate
-        if (regex_match(line, m, gate_re))
+        string_view out = trim(line.substr(0, sep));
+        if (out.empty() || !all_of(out.begin(), out.end(), is_name_char))
+            throw unrecognized();
+
+        string_view rest = trim(line.substr(sep + 1));
+        size_t typeLen = 0;
+        while (typeLen < rest.size() && ((rest[typeLen] >= 'A' && rest[typeLen] <= 'Z') ||
+                                         (rest[typeLen] >= 'a' && rest[typeLen] <= 'z')))
+            ++typeLen;
+        string_view args;
+        if (typeLen == 0 || !parse_parens(rest.substr(typeLen), args))
+            throw unrecognized();
+
+        int t = 0;
+        while (t < (int)size(kSupported) && !iequals(rest.substr(0, typeLen), kSupported[t]))
+            ++t;
+        if (t == (int)size(kSupported))
         {
-            string out = trim(m[1].str());
-            string gtype = to_upper(trim(m[2].str()));
-            vector<string> ins = split_csv(m[3].str());
+            string name(rest.substr(0, typeLen));
+            transform(name.begin(), name.end(), name.begin(), upper);
+            throw BenchParserError("Unsupported gate '" + name + "' at line " + to_string(lineno));
+        }
+        const GateType gtype = static_cast<GateType>(t);
+        const string gname = kSupported[t];
 
-            if (!kSupported.count(gtype))
-            {
-                throw BenchParserError("Unsupported gate '" + gtype + "' at line " + to_string(lineno));
-            }
-            if ((gtype == "NOT" || gtype == "BUFF") && ins.size() != 1)
-            {
-                throw BenchParserError(gtype + " must have exactly 1 input at line " + to_string(lineno));
-            }
-            if (gtype == "XOR" && ins.size() != 2)
-            {
-                throw BenchParserError("XOR must have exactly 2 inputs at line " + to_string(lineno));
-            }
-            if ((gtype == "AND" || gtype == "NAND" || gtype == "OR" || gtype == "NOR") && ins.size() < 2)
-            {
-                throw BenchParserError(gtype + " must have at least 2 inputs at line " + to_string(lineno));
-            }
+        split_csv(args, tokens);
+        const size_t numIns = tokens.size();
 
-            ckt.gates.push_back(Gate{move(ins), out, gtype});
-            continue;
+        if ((gtype == GateType::NOT || gtype == GateType::BUFF) && numIns != 1)
+        {
+            throw BenchParserError(gname + " must have exactly 1 input at line " + to_string(lineno));
+        }
+        if ((gtype == GateType::AND || gtype == GateType::NAND || gtype == GateType::OR || gtype == GateType::NOR ||
+             gtype == GateType::XOR) &&
+            numIns < 2)
+        {
+            throw BenchParserError(gname + " must have at least 2 inputs at line " + to_string(lineno));
         }
 
-        throw BenchParserError("Unrecognized .bench line at " + to_string(lineno) + ": " + line);
+        int z = intern(out);
+        if (ckt.driver[z] >= 0)
+        {
+            throw BenchParserError("Net '" + string(out) + "' is driven more than once at line " + to_string(lineno));
+        }
+        ckt.driver[z] = (int)ckt.gates.size();
+
+        Gate g{gtype, z, (unsigned)ckt.fanin.size(), 0};
+        for (string_view name : tokens)
+            ckt.fanin.push_back(intern(name));
+        g.end = (unsigned)ckt.fanin.size();
+        ckt.gates.push_back(g);
     }
 
-    ckt.inputs = dedup_preserve(ckt.inputs);
-    ckt.outputs = dedup_preserve(ckt.outputs);
+    dedup_preserve(ckt.inputs, ckt.num_nets());
+    dedup_preserve(ckt.outputs, ckt.num_nets());
+    for (int x : ckt.inputs)
+    {
+        if (ckt.driver[x] >= 0)
+            throw BenchParserError("Primary input '" + string(ckt.names[x]) + "' is also driven by a gate");
+    }
+    build_topo(ckt);
     return ckt;
 }
 
-using namespace std;
-
 void print_circuit(const Circuit &c)
 {
     cout << "Inputs  (" << c.inputs.size() << "): ";
-    for (auto &s : c.inputs)
-        cout << s << " ";
+    for (int x : c.inputs)
+        cout << c.names[x] << " ";
     cout << "\nOutputs (" << c.outputs.size() << "): ";
-    for (auto &s : c.outputs)
-        cout << s << " ";
+    for (int x : c.outputs)
+        cout << c.names[x] << " ";
     cout << "\nGates   (" << c.gates.size() << ")\n";
     for (const auto &g : c.gates)
     {
-        cout << "  " << g.out << " = " << g.type << "(";
-        for (size_t i = 0; i < g.ins.size(); ++i)
+        cout << "  " << c.names[g.out] << " = " << gate_type_name(g.type) << "(";
+        for (const int *p = c.ins_begin(g); p != c.ins_end(g); ++p)
         {
-            cout << g.ins[i] << (i + 1 < g.ins.size() ? ", " : "");
+            cout << c.names[*p] << (p + 1 != c.ins_end(g) ? ", " : "");
         }
         cout << ")\n";
     }
-}
\ No newline at end of file
+}
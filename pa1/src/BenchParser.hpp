@@ -1,23 +1,51 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stdexcept>
 #include <unordered_set>
 
 using namespace std;
 
+enum class GateType : uint8_t
+{
+    AND,
+    NAND,
+    OR,
+    NOR,
+    NOT,
+    XOR,
+    BUFF
+};
+
+const char *gate_type_name(GateType t); // "AND", "NAND", ...
+
 struct Gate
 {
-    vector<string> ins; // input pin names (order preserved)
-    string out;         // output pin name
-    string type;        // AND, NAND, OR, NOR, NOT, XOR, BUFF
+    GateType type;
+    int out;             // driven net id
+    unsigned begin, end; // input net ids: Circuit::fanin[begin, end), order preserved
 };
 
+// Netlist IR. Every name is interned once into a net id (index into names);
+// everything else is in terms of ids. Names are views into the .bench text,
+// which the Circuit keeps alive.
 struct Circuit
 {
-    vector<string> inputs;  // deduped, order-preserving
-    vector<string> outputs; // deduped, order-preserving
-    vector<Gate> gates;
+    vector<string_view> names; // net id -> name
+    vector<int> inputs;        // net ids, deduped, order-preserving
+    vector<int> outputs;       // net ids, deduped, order-preserving
+    vector<Gate> gates;        // in file order
+    vector<int> fanin;         // all gate inputs, flat
+    vector<int> driver;        // net id -> index of the gate driving it, -1 if none
+    vector<int> topo;          // gate indices, every gate after the gates driving its inputs
+    shared_ptr<const void> text; // the mapped (or read) file the views point into
+
+    size_t num_nets() const { return names.size(); }
+    const int *ins_begin(const Gate &g) const { return fanin.data() + g.begin; }
+    const int *ins_end(const Gate &g) const { return fanin.data() + g.end; }
 };
 
 class BenchParserError : public runtime_error
@@ -27,4 +55,4 @@ public:
 };
 
 Circuit parse_bench(const string &path);
-void print_circuit(const Circuit &c);
\ No newline at end of file
+void print_circuit(const Circuit &c);
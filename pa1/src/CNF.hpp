@@ -1,6 +1,9 @@
 #pragma once
+#include <cstdint>
+#include <cstdio>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <initializer_list>
 #include <ostream>
@@ -8,24 +11,110 @@
 #include <iomanip>
 using namespace std;
 
+// Clauses live back to back in one literal arena; clause i is
+// lits[start[i] .. start[i + 1]).
 struct CNF
 {
     int var_cnt = 0;
-    vector<vector<int>> clauses;
+    vector<int> lits;
+    vector<size_t> start{0};
+
+    struct Clause
+    {
+        const int *b, *e;
+        const int *begin() const { return b; }
+        const int *end() const { return e; }
+        size_t size() const { return (size_t)(e - b); }
+        int operator[](size_t i) const { return b[i]; }
+    };
 
     int new_var() { return ++var_cnt; }
-    void add_clause(initializer_list<int> lits) { clauses.emplace_back(lits); }
-    void add_clause(const vector<int> &lits) { clauses.push_back(lits); }
+    size_t num_clauses() const { return start.size() - 1; }
+    Clause clause(size_t i) const { return Clause{lits.data() + start[i], lits.data() + start[i + 1]}; }
 
-    void write_dimacs(ostream &os) const
+    void add_clause(initializer_list<int> cl) { add_clause(cl.begin(), cl.end()); }
+    void add_clause(const vector<int> &cl) { add_clause(cl.data(), cl.data() + cl.size()); }
+    void add_clause(const int *b, const int *e)
     {
-        os << "p cnf " << var_cnt << " " << clauses.size() << "\n";
-        for (const auto &cl : clauses)
+        lits.insert(lits.end(), b, e);
+        start.push_back(lits.size());
+    }
+
+    // DIMACS text, formatted by hand into a buffer that is handed to
+    // flush(const char *, size_t) whenever it fills up
+    template <class Flush>
+    void write_dimacs_chunks(Flush flush) const
+    {
+        static const size_t kBuf = 1 << 20;
+        vector<char> buf(kBuf + 64);
+        char *p = buf.data();
+        char *const limit = buf.data() + kBuf;
+
+        p = put_text(p, "p cnf ");
+        p = put_uint(p, (uint64_t)var_cnt);
+        *p++ = ' ';
+        p = put_uint(p, num_clauses());
+        *p++ = '\n';
+        for (size_t i = 0; i < num_clauses(); ++i)
         {
-            for (int lit : cl)
-                os << lit << " ";
-            os << "0\n";
+            for (int l : clause(i))
+            {
+                if (l < 0)
+                {
+                    *p++ = '-';
+                    l = -l;
+                }
+                p = put_uint(p, (uint64_t)l);
+                *p++ = ' ';
+                if (p >= limit)
+                {
+                    flush(buf.data(), (size_t)(p - buf.data()));
+                    p = buf.data();
+                }
+            }
+            *p++ = '0';
+            *p++ = '\n';
+            if (p >= limit)
+            {
+                flush(buf.data(), (size_t)(p - buf.data()));
+                p = buf.data();
+            }
         }
+        if (p != buf.data())
+            flush(buf.data(), (size_t)(p - buf.data()));
+    }
+
+    void write_dimacs(ostream &os) const
+    {
+        write_dimacs_chunks([&](const char *d, size_t n)
+                            { os.write(d, (streamsize)n); });
+    }
+
+    void write_dimacs(FILE *f) const
+    {
+        write_dimacs_chunks([&](const char *d, size_t n)
+                            { fwrite(d, 1, n, f); });
+    }
+
+private:
+    static char *put_text(char *p, const char *s)
+    {
+        while (*s)
+            *p++ = *s++;
+        return p;
+    }
+    static char *put_uint(char *p, uint64_t v)
+    {
+        char tmp[20];
+        int n = 0;
+        do
+        {
+            tmp[n++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v);
+        while (n)
+            *p++ = tmp[--n];
+        return p;
     }
 };
 
@@ -33,10 +122,20 @@ struct CNF
 
 struct PinTable
 {
-    unordered_map<string, int> pi_to_var;  // PIs shared across circuits by name
-    unordered_map<string, int> net_to_var; // internal nets: prefix/name
+    // PIs shared across circuits by name (views into the parsed circuits,
+    // which must outlive the table)
+    unordered_map<string_view, int> pi_to_var;
+
+    // Internal nets of one encoded circuit: net id -> var (0 = none yet)
+    struct Scope
+    {
+        string prefix;
+        const vector<string_view> *names;
+        vector<int> net_to_var;
+    };
+    vector<Scope> scopes;
 
-    int get_or_create_pi(CNF &cnf, const string &name)
+    int get_or_create_pi(CNF &cnf, string_view name)
     {
         auto it = pi_to_var.find(name);
         if (it != pi_to_var.end())
@@ -45,18 +144,9 @@ struct PinTable
         pi_to_var[name] = v;
         return v;
     }
-    int get_or_create_net(CNF &cnf, const string &scoped_name)
-    {
-        auto it = net_to_var.find(scoped_name);
-        if (it != net_to_var.end())
-            return it->second;
-        int v = cnf.new_var();
-        net_to_var[scoped_name] = v;
-        return v;
-    }
 };
 
-void print_PinTable(PinTable &pt)
+inline void print_PinTable(PinTable &pt)
 {
     cout << "================ PinTable ================\n";
 
@@ -73,16 +163,21 @@ void print_PinTable(PinTable &pt)
     }
 
     cout << "\n[Internal Nets]\n";
-    if (pt.net_to_var.empty())
-    {
-        cout << "  (none)\n";
-    }
-    else
+    bool any = false;
+    for (const auto &sc : pt.scopes)
     {
-        for (const auto &n : pt.net_to_var)
-            cout << "  " << setw(20) << left << n.first
-                 << " -> var " << n.second << "\n";
+        for (size_t n = 0; n < sc.net_to_var.size(); ++n)
+        {
+            string_view name = (*sc.names)[n];
+            if (!sc.net_to_var[n] || pt.pi_to_var.count(name))
+                continue;
+            cout << "  " << setw(20) << left << (sc.prefix + "/" + string(name))
+                 << " -> var " << sc.net_to_var[n] << "\n";
+            any = true;
+        }
     }
+    if (!any)
+        cout << "  (none)\n";
 
     cout << "=========================================\n";
 }
\ No newline at end of file
@@ -0,0 +1,301 @@
+#pragma once
+#include "AIG.hpp"
+#include "Sim.hpp"
+#include "Solver.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+struct FraigStats
+{
+    size_t proved = 0;    // node pairs merged after SAT proved them equal
+    size_t disproved = 0; // candidate pairs refuted (counterexample recorded)
+    size_t undecided = 0; // candidate pairs given up on (conflict limit)
+    bool limited = false; // stopped calling SAT: effort limit reached
+};
+
+// SAT sweeping ("fraiging") of an AIG.
+//
+// Random simulation groups the nodes into candidate classes by signature
+// (equal or complementary on every pattern). The AIG is then rebuilt node
+// by node in topological order; each new node is checked against the
+// earlier representatives of its class with two small SAT calls on one
+// incremental solver, under assumptions, and replaced by the representative
+// when they are proven equal. Every merge is picked up by structural
+// hashing in the nodes above it. Counterexamples from refuted pairs become
+// extra simulation patterns that filter later candidates, so most wrong
+// candidates never reach the solver.
+class Fraig
+{
+public:
+    static constexpr int kSimPasses = 4;            // 1024 random patterns
+    static constexpr int64_t kConflictLimit = 1000; // per SAT call
+    static constexpr size_t kMaxCexWords = 8;       // keep up to 512 counterexamples
+    static constexpr int kMaxTries = 2;             // SAT-checked representatives per node
+    static constexpr uint64_t kEffortPerNode = 256; // solver propagations, overall
+
+    FraigStats stats;
+
+    explicit Fraig(const AIG &aig) : old_(aig) {}
+
+    // The swept AIG; lits (literals of the old AIG) are remapped into it
+    AIG run(vector<int> &lits)
+    {
+        const int numNodes = (int)old_.num_nodes();
+        build_classes();
+
+        AIG out;
+        map_.assign(numNodes, -1);
+        map_[0] = 0;
+        newVar_.assign(1, 0);
+        const uint64_t effort = kEffortPerNode * numNodes + (1 << 20);
+        size_t nextPi = 0;
+        for (int n = 1; n < numNodes; ++n)
+        {
+            if (old_.is_pi(n))
+            {
+                size_t k = nextPi++;
+                map_[n] = old_.pi_shared[k] ? out.mk_pi(old_.pi_names[k]) : out.mk_free(old_.pi_names[k]);
+                piNodes_.push_back(n);
+                if (classOf_[n] >= 0)
+                    reps_[classOf_[n]].push_back(n);
+                continue;
+            }
+
+            map_[n] = out.mk_and(map_lit(old_.fanin0[n]), map_lit(old_.fanin1[n]));
+            for (size_t w = 0; w < cex_.size(); ++w)
+                cex_eval(w, n);
+            if (classOf_[n] < 0)
+                continue;
+            if (solver_.propagations > effort)
+            {
+                // weak signatures (e.g. nodes that are almost constant) can
+                // keep the solver refuting candidates; just rebuild the rest
+                stats.limited = true;
+                continue;
+            }
+
+            bool merged = false;
+            int tries = 0;
+            for (int r : reps_[classOf_[n]])
+            {
+                bool c = sim_.phase[n] != sim_.phase[r];
+                int target = map_[r] ^ (int)c;
+                if (map_[n] == target)
+                {
+                    merged = true; // already the same node after earlier merges
+                    break;
+                }
+                if (!cex_agree(n, r, c) || tries++ == kMaxTries)
+                    continue;
+                int res = prove_equal(out, map_[n], target);
+                if (res == 1)
+                {
+                    map_[n] = target;
+                    merged = true;
+                    break;
+                }
+                if (res == 0)
+                    add_cex(n);
+            }
+            if (!merged)
+                reps_[classOf_[n]].push_back(n);
+        }
+
+        for (int &l : lits)
+            l = map_lit(l);
+        return out;
+    }
+
+private:
+    const AIG &old_;
+    SimSignatures sim_;
+    vector<int> classOf_;        // old node -> candidate class, -1 if alone
+    vector<vector<int>> reps_;   // per class: unmerged old nodes seen so far
+    vector<int> map_;            // old node -> literal in the new AIG
+    vector<int> piNodes_;        // old PI nodes
+    vector<vector<uint64_t>> cex_; // counterexample patterns: [word][old node]
+    size_t numCex_ = 0;
+
+    Solver solver_;
+    vector<int> newVar_; // new node -> solver var, 0 = not encoded yet
+
+    int map_lit(int lit) const { return map_[AIG::lit_node(lit)] ^ (lit & 1); }
+
+    // ---- random simulation of the old AIG ----
+
+    void build_classes()
+    {
+        const int numNodes = (int)old_.num_nodes();
+        vector<SimWord> val(numNodes);
+        SimRng rng(1);
+        sim_.resize(numNodes);
+        for (int p = 0; p < kSimPasses; ++p)
+        {
+            val[0] = SimWord{};
+            for (int n = 1; n < numNodes; ++n)
+            {
+                if (old_.is_pi(n))
+                {
+                    rng.fill(val[n]);
+                    continue;
+                }
+                SimWord a = lit_val(val, old_.fanin0[n]);
+                a &= lit_val(val, old_.fanin1[n]);
+                val[n] = a;
+            }
+            sim_.add(val);
+        }
+
+        vector<int> order(numNodes);
+        for (int n = 0; n < numNodes; ++n)
+            order[n] = n;
+        stable_sort(order.begin(), order.end(), [&](int a, int b)
+                    { return sim_.sig[a] < sim_.sig[b]; });
+        classOf_.assign(numNodes, -1);
+        for (size_t i = 0, j; i < order.size(); i = j)
+        {
+            for (j = i + 1; j < order.size() && sim_.sig[order[j]] == sim_.sig[order[i]]; ++j)
+                ;
+            if (j - i < 2)
+                continue;
+            for (size_t k = i; k < j; ++k)
+                classOf_[order[k]] = (int)reps_.size();
+            reps_.emplace_back();
+        }
+        // the constant node is processed first, so it represents its class
+        if (classOf_[0] >= 0)
+            reps_[classOf_[0]].push_back(0);
+    }
+
+    static SimWord lit_val(const vector<SimWord> &val, int lit)
+    {
+        const SimWord &v = val[AIG::lit_node(lit)];
+        return AIG::lit_compl(lit) ? ~v : v;
+    }
+
+    // ---- counterexample patterns ----
+
+    void cex_eval(size_t w, int n)
+    {
+        vector<uint64_t> &v = cex_[w];
+        uint64_t a = v[AIG::lit_node(old_.fanin0[n])] ^ (AIG::lit_compl(old_.fanin0[n]) ? ~0ULL : 0);
+        uint64_t b = v[AIG::lit_node(old_.fanin1[n])] ^ (AIG::lit_compl(old_.fanin1[n]) ? ~0ULL : 0);
+        v[n] = a & b;
+    }
+
+    bool cex_agree(int n, int r, bool c) const
+    {
+        uint64_t m = c ? ~0ULL : 0;
+        for (const vector<uint64_t> &v : cex_)
+            if ((v[n] ^ v[r]) != m)
+                return false;
+        return true;
+    }
+
+    // Record the solver's model as a new pattern and re-simulate it on the
+    // nodes processed so far (up to n)
+    void add_cex(int n)
+    {
+        size_t w = numCex_ / 64, bit = numCex_ % 64;
+        if (w == cex_.size())
+        {
+            if (w == kMaxCexWords)
+                return;
+            cex_.emplace_back(old_.num_nodes(), 0);
+        }
+        ++numCex_;
+        vector<uint64_t> &v = cex_[w];
+        for (int p : piNodes_)
+        {
+            int node = AIG::lit_node(map_[p]);
+            int var = node < (int)newVar_.size() ? newVar_[node] : 0;
+            if (var && solver_.model_value(var))
+                v[p] |= 1ULL << bit;
+        }
+        for (int k = 1; k <= n; ++k)
+            if (old_.is_and(k))
+                cex_eval(w, k);
+    }
+
+    // ---- SAT ----
+
+    // Solver literal of a new-AIG literal, Tseitin-encoding its cone on demand
+    int sat_lit(const AIG &out, int lit)
+    {
+        int node = AIG::lit_node(lit);
+        if (newVar_.size() < out.num_nodes())
+            newVar_.resize(out.num_nodes(), 0);
+        vector<int> stack{node};
+        while (!stack.empty())
+        {
+            int t = stack.back();
+            if (newVar_[t])
+            {
+                stack.pop_back();
+                continue;
+            }
+            if (out.is_and(t))
+            {
+                int a = AIG::lit_node(out.fanin0[t]), b = AIG::lit_node(out.fanin1[t]);
+                if (!newVar_[a] || !newVar_[b])
+                {
+                    if (!newVar_[a])
+                        stack.push_back(a);
+                    if (!newVar_[b])
+                        stack.push_back(b);
+                    continue;
+                }
+            }
+            stack.pop_back();
+            int v = newVar_[t] = solver_.num_vars() + 1;
+            solver_.reserve_vars(v);
+            if (t == 0)
+                solver_.add_clause({-v}); // constant FALSE
+            else if (out.is_and(t))
+            {
+                int x = sat_of(out.fanin0[t]), y = sat_of(out.fanin1[t]);
+                solver_.set_decision_var(v, false); // implied by the PIs
+                solver_.add_clause({-v, x});
+                solver_.add_clause({-v, y});
+                solver_.add_clause({v, -x, -y});
+            }
+        }
+        return sat_of(lit);
+    }
+
+    int sat_of(int lit) const
+    {
+        int v = newVar_[AIG::lit_node(lit)];
+        return AIG::lit_compl(lit) ? -v : v;
+    }
+
+    // 1: a == b proven, 0: refuted (the solver holds a model), -1: undecided
+    int prove_equal(const AIG &out, int a, int b)
+    {
+        int x = sat_lit(out, a), y = sat_lit(out, b);
+        int r1 = solver_.solve_limited({x, -y}, kConflictLimit);
+        if (r1 == 1)
+        {
+            ++stats.disproved;
+            return 0;
+        }
+        int r2 = solver_.solve_limited({-x, y}, kConflictLimit);
+        if (r2 == 1)
+        {
+            ++stats.disproved;
+            return 0;
+        }
+        if (r1 == 0 && r2 == 0)
+        {
+            // keep the equivalence for later queries as well
+            solver_.add_clause({-x, y});
+            solver_.add_clause({x, -y});
+            ++stats.proved;
+            return 1;
+        }
+        ++stats.undecided;
+        return -1;
+    }
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include "CNF.hpp"
+#include "Preprocess.hpp"
+#include "Solver.hpp"
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+struct MiterPoolResult
+{
+    vector<char> proven; // per miter: proven equal (UNSAT)
+    int failing = -1;    // a miter found SAT, -1 if none
+    unordered_map<string_view, bool> cex; // PI values of its model
+    uint64_t conflicts = 0;
+};
+
+// Solve many small, independent miters on a pool of threads.
+//
+// build(j, cnf, pt) encodes miter j (typically one output pair's cones) and
+// returns the literal that is true when the pair differs. Workers take the
+// miters in order; the first SAT result stops everyone, solvers still
+// running are interrupted and their miters stay unproven. With simp, each
+// miter is run through the Preprocessor before it is solved.
+template <class Build>
+MiterPoolResult solve_miters(size_t numMiters, int threads, Build build, bool simp = false)
+{
+    MiterPoolResult res;
+    res.proven.assign(numMiters, 0);
+    atomic<size_t> next{0};
+    atomic<bool> stop{false};
+    atomic<uint64_t> conflicts{0};
+    mutex m;
+
+    auto worker = [&]
+    {
+        for (size_t j; !stop.load(memory_order_relaxed) && (j = next++) < numMiters;)
+        {
+            CNF cnf;
+            PinTable pt;
+            int diff = build(j, cnf, pt);
+            cnf.add_clause({diff});
+            Preprocessor pre;
+            if (simp && !pre.run(cnf))
+            {
+                res.proven[j] = 1;
+                continue;
+            }
+
+            Solver solver;
+            solver.set_interrupt(&stop);
+            solver.add_cnf(cnf);
+            int r = solver.solve_limited({}, -1);
+            conflicts += solver.conflicts;
+            if (r == 0)
+                res.proven[j] = 1;
+            else if (r == 1)
+            {
+                lock_guard<mutex> lock(m);
+                if (res.failing < 0)
+                {
+                    res.failing = (int)j;
+                    vector<char> model(cnf.var_cnt + 1);
+                    for (int v = 1; v <= cnf.var_cnt; ++v)
+                        model[v] = solver.model_value(v);
+                    pre.extend_model(model);
+                    for (const auto &p : pt.pi_to_var)
+                        res.cex[p.first] = model[p.second];
+                }
+                stop = true;
+            }
+        }
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (thread &t : pool)
+        t.join();
+
+    res.conflicts = conflicts;
+    return res;
+}
@@ -0,0 +1,414 @@
+#include "Preprocess.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+void Preprocessor::freeze(int v)
+{
+    if ((int)frozen_.size() <= v)
+        frozen_.resize(v + 1, 0);
+    frozen_[v] = 1;
+}
+
+// ---- clause database ----
+
+void Preprocessor::add_clause(vector<int> &cl)
+{
+    sort(cl.begin(), cl.end(), [](int a, int b)
+         { return li(a) < li(b); });
+    size_t n = 0;
+    for (size_t i = 0; i < cl.size(); ++i)
+    {
+        int l = cl[i];
+        if (value(l) == 1 || (n > 0 && cl[n - 1] == -l))
+            return; // satisfied or tautology
+        if (value(l) == -1 || (n > 0 && cl[n - 1] == l))
+            continue; // false or duplicate
+        cl[n++] = l;
+    }
+    cl.resize(n);
+    if (n == 0)
+    {
+        ok_ = false;
+        return;
+    }
+    if (n == 1)
+    {
+        assign(cl[0]);
+        return;
+    }
+
+    uint32_t c = (uint32_t)clauses_.size();
+    Clause info{lits_.size(), (uint32_t)n, false, 0};
+    for (int l : cl)
+    {
+        info.abst |= 1ULL << (abs(l) & 63);
+        occ_[li(l)].push_back(c);
+        ++nocc_[li(l)];
+        touched_[abs(l)] = 1;
+    }
+    lits_.insert(lits_.end(), cl.begin(), cl.end());
+    clauses_.push_back(info);
+    queued_.push_back(1);
+    subQueue_.push_back(c);
+}
+
+void Preprocessor::remove_clause(uint32_t c)
+{
+    Clause &cl = clauses_[c];
+    cl.dead = true;
+    for (const int *l = clits(c), *e = l + cl.size; l != e; ++l)
+    {
+        --nocc_[li(*l)];
+        touched_[abs(*l)] = 1;
+    }
+}
+
+// Drop literal l from clause c
+void Preprocessor::strengthen(uint32_t c, int l)
+{
+    Clause &cl = clauses_[c];
+    int *lits = clits(c);
+    uint32_t k = 0;
+    while (lits[k] != l)
+        ++k;
+    // keep the literals sorted, as add_clause() left them
+    copy(lits + k + 1, lits + cl.size, lits + k);
+    --cl.size;
+
+    vector<uint32_t> &o = occ_[li(l)];
+    auto it = find(o.begin(), o.end(), c);
+    *it = o.back();
+    o.pop_back();
+    --nocc_[li(l)];
+    touched_[abs(l)] = 1;
+
+    cl.abst = 0;
+    for (uint32_t i = 0; i < cl.size; ++i)
+        cl.abst |= 1ULL << (abs(lits[i]) & 63);
+
+    if (cl.size == 1)
+    {
+        int u = lits[0];
+        remove_clause(c);
+        assign(u);
+    }
+    else if (!queued_[c])
+    {
+        queued_[c] = 1;
+        subQueue_.push_back(c);
+    }
+}
+
+const vector<uint32_t> &Preprocessor::occs(int l)
+{
+    vector<uint32_t> &o = occ_[li(l)];
+    if (o.size() != nocc_[li(l)])
+        o.erase(remove_if(o.begin(), o.end(), [&](uint32_t c)
+                          { return clauses_[c].dead; }),
+                o.end());
+    return o;
+}
+
+// ---- unit propagation ----
+
+void Preprocessor::assign(int l)
+{
+    if (value(l) != 0)
+    {
+        if (value(l) < 0)
+            ok_ = false;
+        return;
+    }
+    int v = abs(l);
+    val_[v] = l > 0 ? 1 : -1;
+    trail_.push_back(l);
+    ++stats.units;
+    if (!frozen_[v])
+    {
+        elimStack_.push_back(l);
+        elimStack_.push_back(1);
+    }
+}
+
+bool Preprocessor::propagate()
+{
+    vector<uint32_t> cs;
+    while (ok_ && qhead_ < trail_.size())
+    {
+        int l = trail_[qhead_++];
+        cs = occs(l);
+        for (uint32_t c : cs)
+            if (!clauses_[c].dead)
+                remove_clause(c);
+        cs = occs(-l);
+        for (uint32_t c : cs)
+            if (!clauses_[c].dead)
+                strengthen(c, -l);
+    }
+    return ok_;
+}
+
+// ---- subsumption ----
+
+int Preprocessor::subsumes(uint32_t c, uint32_t d)
+{
+    const int *dl = clits(d), *de = dl + clauses_[d].size;
+    for (const int *l = dl; l != de; ++l)
+        mark_[li(*l)] = 1;
+    int res = 0;
+    for (const int *l = clits(c), *e = l + clauses_[c].size; l != e; ++l)
+    {
+        if (mark_[li(*l)])
+            continue;
+        if (res == 0 && mark_[li(-*l)])
+        {
+            res = -*l; // resolving on it leaves d without this literal
+            continue;
+        }
+        res = kNoSubsume;
+        break;
+    }
+    for (const int *l = dl; l != de; ++l)
+        mark_[li(*l)] = 0;
+    return res;
+}
+
+// Use every queued clause c to remove the clauses it subsumes, and to
+// strengthen those it subsumes but for one complemented literal
+void Preprocessor::backward_subsume()
+{
+    vector<uint32_t> ds;
+    while (ok_ && !subQueue_.empty())
+    {
+        uint32_t c = subQueue_.back();
+        subQueue_.pop_back();
+        queued_[c] = 0;
+        if (clauses_[c].dead)
+            continue;
+
+        // every candidate contains c's rarest variable
+        int best = 0;
+        size_t bestOcc = SIZE_MAX;
+        for (const int *l = clits(c), *e = l + clauses_[c].size; l != e; ++l)
+        {
+            size_t n = nocc_[li(*l)] + nocc_[li(-*l)];
+            if (n < bestOcc)
+            {
+                bestOcc = n;
+                best = *l;
+            }
+        }
+        if (bestOcc > kMaxSubsumeOcc)
+            continue;
+
+        for (int s : {best, -best})
+        {
+            ds = occs(s);
+            for (uint32_t d : ds)
+            {
+                if (clauses_[c].dead)
+                    break;
+                const Clause &cd = clauses_[d];
+                if (d == c || cd.dead || cd.size < clauses_[c].size || (clauses_[c].abst & ~cd.abst))
+                    continue;
+                int r = subsumes(c, d);
+                if (r == 0)
+                {
+                    remove_clause(d);
+                    ++stats.subsumed;
+                }
+                else if (r != kNoSubsume)
+                {
+                    strengthen(d, r);
+                    ++stats.strengthened;
+                }
+            }
+        }
+        propagate();
+    }
+}
+
+// ---- variable elimination ----
+
+// The resolvent of c and d on v into out; false if it is a tautology
+bool Preprocessor::resolve(uint32_t c, uint32_t d, int v, vector<int> &out)
+{
+    out.clear();
+    const int *cl = clits(c), *ce = cl + clauses_[c].size;
+    for (const int *l = cl; l != ce; ++l)
+        if (abs(*l) != v)
+        {
+            out.push_back(*l);
+            mark_[li(*l)] = 1;
+        }
+    bool taut = false;
+    for (const int *l = clits(d), *e = l + clauses_[d].size; l != e; ++l)
+    {
+        if (abs(*l) == v || mark_[li(*l)])
+            continue;
+        if (mark_[li(-*l)])
+        {
+            taut = true;
+            break;
+        }
+        out.push_back(*l);
+    }
+    for (const int *l = cl; l != ce; ++l)
+        mark_[li(*l)] = 0;
+    return !taut;
+}
+
+void Preprocessor::push_elim(uint32_t c, int pivot)
+{
+    size_t first = elimStack_.size();
+    elimStack_.push_back(pivot);
+    for (const int *l = clits(c), *e = l + clauses_[c].size; l != e; ++l)
+        if (*l != pivot)
+            elimStack_.push_back(*l);
+    elimStack_.push_back((int)(elimStack_.size() - first));
+}
+
+// Replace the clauses of v by all their non-tautological resolvents on v,
+// if there are no more of those than clauses removed
+bool Preprocessor::eliminate_var(int v)
+{
+    if (frozen_[v] || eliminated_[v] || val_[v] != 0)
+        return false;
+    const vector<uint32_t> pos = occs(v), neg = occs(-v);
+    if (pos.size() * neg.size() > kMaxResolveWork)
+        return false;
+
+    size_t count = 0;
+    for (uint32_t p : pos)
+        for (uint32_t n : neg)
+            if (resolve(p, n, v, resolvent_) &&
+                (++count > pos.size() + neg.size() || resolvent_.size() > kMaxResolvent))
+                return false;
+
+    // Reconstruction: v defaults to the value satisfying the larger side,
+    // and is flipped for any clause of the smaller side left unsatisfied
+    const bool posSmaller = pos.size() <= neg.size();
+    for (uint32_t c : posSmaller ? pos : neg)
+        push_elim(c, posSmaller ? v : -v);
+    elimStack_.push_back(posSmaller ? -v : v);
+    elimStack_.push_back(1);
+
+    eliminated_[v] = 1;
+    ++stats.eliminated;
+    for (uint32_t c : pos)
+        remove_clause(c);
+    for (uint32_t c : neg)
+        remove_clause(c);
+    // removed clauses keep their literals in lits_ until run() is over
+    for (uint32_t p : pos)
+        for (uint32_t n : neg)
+            if (resolve(p, n, v, resolvent_))
+                add_clause(resolvent_);
+    return true;
+}
+
+// ---- driver ----
+
+bool Preprocessor::run(CNF &cnf)
+{
+    const int n = cnf.var_cnt;
+    stats.clausesBefore = cnf.num_clauses();
+    frozen_.resize(n + 1, 0);
+    eliminated_.assign(n + 1, 0);
+    touched_.assign(n + 1, 0);
+    val_.assign(n + 1, 0);
+    occ_.assign(2 * (size_t)(n + 1), {});
+    nocc_.assign(2 * (size_t)(n + 1), 0);
+    mark_.assign(2 * (size_t)(n + 1), 0);
+
+    vector<int> cl;
+    for (size_t i = 0; i < cnf.num_clauses() && ok_; ++i)
+    {
+        CNF::Clause c = cnf.clause(i);
+        cl.assign(c.begin(), c.end());
+        add_clause(cl);
+    }
+    cnf = CNF(); // the copy in lits_ is all that is needed from here on
+    cnf.var_cnt = n;
+
+    propagate();
+    backward_subsume();
+    vector<int> cand;
+    for (int round = 0; ok_ && round < kMaxRounds; ++round)
+    {
+        // variables whose occurrences changed since the last round (all at first)
+        cand.clear();
+        for (int v = 1; v <= n; ++v)
+            if (touched_[v])
+            {
+                touched_[v] = 0;
+                if (!frozen_[v] && !eliminated_[v] && val_[v] == 0)
+                    cand.push_back(v);
+            }
+        auto cost = [&](int v)
+        { return (uint64_t)nocc_[li(v)] * nocc_[li(-v)]; };
+        stable_sort(cand.begin(), cand.end(), [&](int a, int b)
+                    { return cost(a) < cost(b); });
+
+        size_t before = stats.eliminated;
+        for (int v : cand)
+            if (eliminate_var(v) && !propagate())
+                break;
+        backward_subsume();
+        if (stats.eliminated == before)
+            break;
+    }
+
+    if (!ok_)
+    {
+        cnf.var_cnt = max(n, 1);
+        cnf.add_clause({1});
+        cnf.add_clause({-1});
+    }
+    else
+    {
+        // units on frozen variables stay visible to whoever reads the CNF
+        for (int l : trail_)
+            if (frozen_[abs(l)])
+                cnf.add_clause({l});
+        for (uint32_t c = 0; c < clauses_.size(); ++c)
+            if (!clauses_[c].dead)
+                cnf.add_clause(clits(c), clits(c) + clauses_[c].size);
+    }
+    stats.clausesAfter = cnf.num_clauses();
+
+    // only the reconstruction stack is needed after this
+    vector<int>().swap(lits_);
+    vector<Clause>().swap(clauses_);
+    vector<vector<uint32_t>>().swap(occ_);
+    vector<uint32_t>().swap(nocc_);
+    vector<uint32_t>().swap(subQueue_);
+    vector<char>().swap(queued_);
+    return ok_;
+}
+
+void Preprocessor::extend_model(vector<char> &model) const
+{
+    // last in, first out: a variable removed later may occur in an earlier
+    // entry, and must have its final value by then
+    for (size_t i = elimStack_.size(); i > 0;)
+    {
+        size_t size = (size_t)elimStack_[i - 1];
+        size_t b = i - 1 - size;
+        bool sat = false;
+        for (size_t k = b + 1; k < i - 1 && !sat; ++k)
+        {
+            int l = elimStack_[k];
+            sat = (model[abs(l)] != 0) == (l > 0);
+        }
+        if (!sat)
+        {
+            int p = elimStack_[b];
+            model[abs(p)] = p > 0;
+        }
+        i = b;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "CNF.hpp"
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// CNF preprocessing in the style of SatELite: unit propagation, subsumption
+// with self-subsuming resolution, and bounded variable elimination (a
+// variable is resolved away when that does not increase the clause count).
+//
+// Variables keep their numbers (so a PinTable stays valid); eliminated ones
+// just no longer occur. Frozen variables are never eliminated or dropped:
+// those the caller still reads or assumes (e.g. the diff literals of an
+// incremental solve, or the PIs of a DIMACS file meant for an external
+// solver). The clauses removed with each eliminated variable, and the
+// units found, are kept on a reconstruction stack, from which
+// extend_model() turns a model of the simplified CNF into a model of the
+// original one.
+class Preprocessor
+{
+public:
+    static constexpr size_t kMaxResolvent = 20;   // longest clause elimination may add
+    static constexpr size_t kMaxResolveWork = 1 << 12; // clause pairs tried per variable
+    static constexpr size_t kMaxSubsumeOcc = 1000; // skip subsumption through longer occurrence lists
+    static constexpr int kMaxRounds = 8;           // elimination / subsumption rounds
+
+    struct Stats
+    {
+        size_t clausesBefore = 0, clausesAfter = 0;
+        size_t units = 0;        // variables fixed by unit propagation
+        size_t subsumed = 0;     // clauses removed by subsumption
+        size_t strengthened = 0; // literals removed by self-subsuming resolution
+        size_t eliminated = 0;   // variables resolved away
+    };
+    Stats stats;
+
+    void freeze(int v); // v (> 0) must survive with its meaning intact
+
+    // Simplify cnf in place. false: it is unsatisfiable (cnf is then a
+    // trivially unsatisfiable instance)
+    bool run(CNF &cnf);
+
+    // model[v] for v = 1..var_cnt: a model of the simplified CNF in, one of
+    // the original out
+    void extend_model(vector<char> &model) const;
+
+private:
+    struct Clause
+    {
+        size_t beg;
+        uint32_t size;
+        bool dead;
+        uint64_t abst; // bit var % 64 of each literal, a quick subset filter
+    };
+    vector<int> lits_; // clause literals, back to back
+    vector<Clause> clauses_;
+    vector<vector<uint32_t>> occ_; // per literal index: clauses (dead ones removed lazily)
+    vector<uint32_t> nocc_;        // per literal index: live occurrences
+    vector<int8_t> val_;           // per var: 0 unassigned, 1 true, -1 false
+    vector<char> frozen_, eliminated_, touched_, mark_;
+    vector<int> trail_;
+    size_t qhead_ = 0;
+    vector<uint32_t> subQueue_;
+    vector<char> queued_;
+    vector<int> resolvent_;
+    bool ok_ = true;
+
+    // [pivot, other literals..., size] per entry; the pivot is set true
+    // when no other literal of its clause is
+    vector<int> elimStack_;
+
+    static size_t li(int l) { return 2 * (size_t)(l < 0 ? -l : l) + (l < 0); }
+    int value(int l) const { return l > 0 ? val_[l] : -val_[-l]; }
+    int *clits(uint32_t c) { return lits_.data() + clauses_[c].beg; }
+
+    void add_clause(vector<int> &cl); // sorted, checked against the assignment
+    void remove_clause(uint32_t c);
+    void strengthen(uint32_t c, int l);
+    void assign(int l);
+    bool propagate();
+    const vector<uint32_t> &occs(int l);
+    void backward_subsume();
+    static constexpr int kNoSubsume = INT32_MIN;
+    int subsumes(uint32_t c, uint32_t d); // 0: c subsumes d, kNoSubsume, or a literal of d to drop
+    bool resolve(uint32_t c, uint32_t d, int v, vector<int> &out);
+    bool eliminate_var(int v);
+    void push_elim(uint32_t c, int pivot);
+};
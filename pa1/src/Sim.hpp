@@ -0,0 +1,242 @@
+#pragma once
+#include "BenchParser.hpp"
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Bit-parallel random simulation.
+//
+// A SimWord holds kSimWords * 64 input patterns, one per bit; gates are
+// evaluated a word at a time with plain loops the compiler vectorizes.
+constexpr int kSimWords = 4; // 256 patterns per pass
+
+struct alignas(32) SimWord
+{
+    uint64_t w[kSimWords];
+
+    SimWord &operator&=(const SimWord &o)
+    {
+        for (int k = 0; k < kSimWords; ++k)
+            w[k] &= o.w[k];
+        return *this;
+    }
+    SimWord &operator|=(const SimWord &o)
+    {
+        for (int k = 0; k < kSimWords; ++k)
+            w[k] |= o.w[k];
+        return *this;
+    }
+    SimWord &operator^=(const SimWord &o)
+    {
+        for (int k = 0; k < kSimWords; ++k)
+            w[k] ^= o.w[k];
+        return *this;
+    }
+    SimWord operator~() const
+    {
+        SimWord r;
+        for (int k = 0; k < kSimWords; ++k)
+            r.w[k] = ~w[k];
+        return r;
+    }
+    bool any() const
+    {
+        uint64_t a = 0;
+        for (int k = 0; k < kSimWords; ++k)
+            a |= w[k];
+        return a != 0;
+    }
+    bool bit(int i) const { return (w[i >> 6] >> (i & 63)) & 1; }
+    int first_bit() const // -1 if none
+    {
+        for (int k = 0; k < kSimWords; ++k)
+            if (w[k])
+                return 64 * k + __builtin_ctzll(w[k]);
+        return -1;
+    }
+};
+
+// splitmix64: a seeded source of pattern words
+struct SimRng
+{
+    uint64_t s;
+    explicit SimRng(uint64_t seed) : s(seed) {}
+    uint64_t next()
+    {
+        uint64_t z = (s += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    void fill(SimWord &x)
+    {
+        for (int k = 0; k < kSimWords; ++k)
+            x.w[k] = next();
+    }
+};
+
+// Per-node simulation signatures, normalized for polarity: the phase is the
+// node's value on the very first pattern, and a node's words are complemented
+// before hashing when its phase is 1. Nodes that are equal or complementary
+// on every pattern so far get equal signatures.
+struct SimSignatures
+{
+    vector<uint64_t> sig;
+    vector<char> phase;
+    bool started = false;
+
+    void resize(size_t n)
+    {
+        sig.assign(n, 0);
+        phase.assign(n, 0);
+        started = false;
+    }
+
+    // Fold one pass of values (one SimWord per node) into the signatures
+    void add(const vector<SimWord> &val)
+    {
+        if (!started)
+        {
+            for (size_t n = 0; n < val.size(); ++n)
+                phase[n] = (char)(val[n].w[0] & 1);
+            started = true;
+        }
+        for (size_t n = 0; n < val.size(); ++n)
+        {
+            uint64_t m = phase[n] ? ~0ULL : 0;
+            uint64_t h = sig[n];
+            for (int k = 0; k < kSimWords; ++k)
+                h = mix(h ^ (val[n].w[k] ^ m));
+            sig[n] = h;
+        }
+    }
+
+    static uint64_t mix(uint64_t k)
+    {
+        k += 0x9e3779b97f4a7c15ULL;
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+};
+
+// Random simulation of both circuits of the miter, with PIs shared by name
+// (like the CNF encoders) and undriven nets free per circuit.
+//
+// run() simulates passes of kSimWords * 64 patterns in topological order and
+// stops at the first pass on which a pair of outputs differs; the
+// distinguishing pattern can then be read back.
+class PairSim
+{
+public:
+    // pairB[i]: index into B.outputs paired with A.outputs[i]
+    PairSim(const Circuit &A, const Circuit &B, const vector<int> &pairB, uint64_t seed = 1)
+        : A_(A), B_(B), pairB_(pairB), rng_(seed)
+    {
+        unordered_map<string_view, int> pi;
+        auto index = [&](const Circuit &c, vector<int> &toPi, vector<int> &free)
+        {
+            vector<char> isPi(c.num_nets(), 0);
+            for (int x : c.inputs)
+            {
+                toPi.push_back(pi.emplace(c.names[x], (int)pi.size()).first->second);
+                isPi[x] = 1;
+            }
+            for (size_t n = 0; n < c.num_nets(); ++n)
+                if (c.driver[n] < 0 && !isPi[n])
+                    free.push_back((int)n);
+        };
+        index(A, piA_, freeA_);
+        index(B, piB_, freeB_);
+        piVal_.resize(pi.size());
+        valA_.resize(A.num_nets());
+        valB_.resize(B.num_nets());
+    }
+
+    // Simulate up to 'passes' passes; true as soon as a pair of outputs differs
+    bool run(int passes)
+    {
+        for (int p = 0; p < passes; ++p)
+        {
+            for (SimWord &w : piVal_)
+                rng_.fill(w);
+            simulate(A_, piA_, freeA_, valA_);
+            simulate(B_, piB_, freeB_, valB_);
+            ++passes_;
+
+            for (size_t i = 0; i < A_.outputs.size(); ++i)
+            {
+                SimWord d = valA_[A_.outputs[i]];
+                d ^= valB_[B_.outputs[pairB_[i]]];
+                int b = d.first_bit();
+                if (b >= 0)
+                {
+                    failing_ = (int)i;
+                    bit_ = b;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    uint64_t patterns() const { return (uint64_t)passes_ * 64 * kSimWords; }
+
+    // After run() returned true: the differing pair (index into A.outputs)
+    // and the value of net n of A under the distinguishing pattern
+    int failing_output() const { return failing_; }
+    bool value_A(int n) const { return valA_[n].bit(bit_); }
+
+private:
+    const Circuit &A_, &B_;
+    const vector<int> &pairB_;
+    SimRng rng_;
+    vector<int> piA_, piB_;     // per ckt.inputs[k]: index into piVal_
+    vector<int> freeA_, freeB_; // undriven non-input nets
+    vector<SimWord> piVal_, valA_, valB_;
+    int passes_ = 0;
+    int failing_ = -1, bit_ = -1;
+
+    void simulate(const Circuit &c, const vector<int> &pi, const vector<int> &free, vector<SimWord> &val)
+    {
+        for (size_t k = 0; k < c.inputs.size(); ++k)
+            val[c.inputs[k]] = piVal_[pi[k]];
+        for (int n : free)
+            rng_.fill(val[n]);
+
+        for (int gi : c.topo)
+        {
+            const Gate &g = c.gates[gi];
+            const int *p = c.ins_begin(g), *e = c.ins_end(g);
+            SimWord r = val[*p++];
+            switch (g.type)
+            {
+            case GateType::AND:
+            case GateType::NAND:
+                for (; p != e; ++p)
+                    r &= val[*p];
+                break;
+            case GateType::OR:
+            case GateType::NOR:
+                for (; p != e; ++p)
+                    r |= val[*p];
+                break;
+            case GateType::XOR:
+                for (; p != e; ++p)
+                    r ^= val[*p];
+                break;
+            case GateType::NOT:
+            case GateType::BUFF:
+                break;
+            }
+            if (g.type == GateType::NAND || g.type == GateType::NOR || g.type == GateType::NOT)
+                r = ~r;
+            val[g.out] = r;
+        }
+    }
+};
@@ -0,0 +1,597 @@
+#include "Solver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+namespace
+{
+    // Luby sequence 1 1 2 1 1 2 4 ..., scaled by y^k
+    double luby(double y, int x)
+    {
+        int size = 1, seq = 0;
+        while (size < x + 1)
+        {
+            ++seq;
+            size = 2 * size + 1;
+        }
+        while (size - 1 != x)
+        {
+            size = (size - 1) >> 1;
+            --seq;
+            x = x % size;
+        }
+        return pow(y, seq);
+    }
+
+    const double kVarDecay = 0.95;
+    const double kClauseDecay = 0.999;
+    const int kRestartBase = 100;
+}
+
+void Solver::reserve_vars(int n)
+{
+    int old = num_vars();
+    if (n <= old)
+        return;
+    assigns_.resize(n, -1);
+    level_.resize(n, 0);
+    reason_.resize(n, kNoReason);
+    polarity_.resize(n, 1);
+    decision_.resize(n, 1);
+    activity_.resize(n, 0.0);
+    heap_index_.resize(n, -1);
+    seen_.resize(n, 0);
+    watches_.resize(2 * (size_t)n);
+    for (int v = old; v < n; ++v)
+        heap_insert(v);
+}
+
+void Solver::set_decision_var(int v, bool d)
+{
+    reserve_vars(v);
+    decision_[v - 1] = d;
+    if (d && heap_index_[v - 1] < 0 && assigns_[v - 1] < 0)
+        heap_insert(v - 1);
+}
+
+// ---- clauses ----
+
+Solver::CRef Solver::alloc_clause(const vector<int> &lits, bool learnt)
+{
+    CRef c = (CRef)arena_.size();
+    arena_.push_back((uint32_t)lits.size() | (learnt ? 0x80000000u : 0u));
+    arena_.push_back(0);
+    for (int l : lits)
+        arena_.push_back((uint32_t)l);
+    set_cact(c, 0.0f);
+    return c;
+}
+
+void Solver::attach(CRef c)
+{
+    int *lits = clits(c);
+    watches_[lneg(lits[0])].push_back(Watcher{c, lits[1]});
+    watches_[lneg(lits[1])].push_back(Watcher{c, lits[0]});
+}
+
+bool Solver::add_clause(const int *begin, const int *end)
+{
+    if (!ok_)
+        return false;
+    int maxVar = 0;
+    for (const int *d = begin; d != end; ++d)
+        maxVar = max(maxVar, abs(*d));
+    reserve_vars(maxVar);
+
+    // Clauses are only added between solve() calls, i.e. at level 0
+    learnt_.clear();
+    for (const int *d = begin; d != end; ++d)
+        learnt_.push_back(ilit(*d));
+    sort(learnt_.begin(), learnt_.end());
+    size_t n = 0;
+    for (size_t i = 0; i < learnt_.size(); ++i)
+    {
+        int l = learnt_[i];
+        if (value(l) == 1 || (n > 0 && learnt_[n - 1] == lneg(l)))
+            return true; // satisfied or tautology
+        if (value(l) == 0 || (n > 0 && learnt_[n - 1] == l))
+            continue; // false at level 0 or duplicate
+        learnt_[n++] = l;
+    }
+    learnt_.resize(n);
+
+    if (n == 0)
+        return ok_ = false;
+    if (n == 1)
+    {
+        enqueue(learnt_[0], kNoReason);
+        return ok_ = (propagate() == kNoReason);
+    }
+    CRef c = alloc_clause(learnt_, false);
+    clauses_.push_back(c);
+    attach(c);
+    return true;
+}
+
+size_t Solver::add_cnf(const CNF &cnf, size_t first)
+{
+    reserve_vars(cnf.var_cnt);
+    for (size_t i = first; i < cnf.num_clauses(); ++i)
+        add_clause(cnf.clause(i).begin(), cnf.clause(i).end());
+    return cnf.num_clauses();
+}
+
+// ---- assignment and propagation ----
+
+void Solver::enqueue(int l, CRef from)
+{
+    int v = lvar(l);
+    assigns_[v] = (int8_t)((l & 1) ^ 1);
+    level_[v] = decision_level();
+    reason_[v] = from;
+    trail_.push_back(l);
+}
+
+// Propagate everything on the trail; returns a conflicting clause or kNoReason.
+// watches_[p] holds the clauses watching ~p, visited when p becomes true.
+Solver::CRef Solver::propagate()
+{
+    CRef confl = kNoReason;
+    while (qhead_ < trail_.size())
+    {
+        int p = trail_[qhead_++];
+        int falseLit = lneg(p);
+        vector<Watcher> &ws = watches_[p];
+        ++propagations;
+
+        size_t i = 0, j = 0, n = ws.size();
+        while (i < n)
+        {
+            int blocker = ws[i].blocker;
+            if (value(blocker) == 1)
+            {
+                ws[j++] = ws[i++];
+                continue;
+            }
+
+            CRef cr = ws[i].cref;
+            int *c = clits(cr);
+            if (c[0] == falseLit)
+                swap(c[0], c[1]);
+            ++i;
+
+            int first = c[0];
+            Watcher w{cr, first};
+            if (first != blocker && value(first) == 1)
+            {
+                ws[j++] = w;
+                continue;
+            }
+
+            // look for a new literal to watch
+            uint32_t sz = csize(cr);
+            bool moved = false;
+            for (uint32_t k = 2; k < sz; ++k)
+            {
+                if (value(c[k]) != 0)
+                {
+                    c[1] = c[k];
+                    c[k] = falseLit;
+                    watches_[lneg(c[1])].push_back(w);
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved)
+                continue;
+
+            // unit or conflicting
+            ws[j++] = w;
+            if (value(first) == 0)
+            {
+                confl = cr;
+                qhead_ = trail_.size();
+                while (i < n)
+                    ws[j++] = ws[i++];
+            }
+            else
+                enqueue(first, cr);
+        }
+        ws.resize(j);
+        if (confl != kNoReason)
+            break;
+    }
+    return confl;
+}
+
+void Solver::cancel_until(int level)
+{
+    if (decision_level() <= level)
+        return;
+    for (size_t c = trail_.size(); c-- > (size_t)trail_lim_[level];)
+    {
+        int v = lvar(trail_[c]);
+        assigns_[v] = -1;
+        reason_[v] = kNoReason;
+        polarity_[v] = (int8_t)(trail_[c] & 1);
+        if (heap_index_[v] < 0 && decision_[v])
+            heap_insert(v);
+    }
+    qhead_ = trail_lim_[level];
+    trail_.resize(trail_lim_[level]);
+    trail_lim_.resize(level);
+}
+
+// ---- conflict analysis ----
+
+void Solver::analyze(CRef confl, int &btLevel)
+{
+    int pathC = 0;
+    int p = -1;
+    learnt_.clear();
+    learnt_.push_back(-1); // room for the asserting literal
+    size_t index = trail_.size();
+
+    do
+    {
+        if (clearnt(confl))
+            bump_clause(confl);
+        int *c = clits(confl);
+        uint32_t sz = csize(confl);
+        for (uint32_t j = (p == -1) ? 0 : 1; j < sz; ++j)
+        {
+            int q = c[j];
+            int v = lvar(q);
+            if (!seen_[v] && level_[v] > 0)
+            {
+                bump_var(v);
+                seen_[v] = 1;
+                if (level_[v] >= decision_level())
+                    ++pathC;
+                else
+                    learnt_.push_back(q);
+            }
+        }
+        // next literal of the current level on the trail
+        while (!seen_[lvar(trail_[--index])])
+            ;
+        p = trail_[index];
+        confl = reason_[lvar(p)];
+        seen_[lvar(p)] = 0;
+        --pathC;
+    } while (pathC > 0);
+    learnt_[0] = lneg(p);
+
+    // drop literals implied by the rest of the clause
+    to_clear_.assign(learnt_.begin(), learnt_.end());
+    uint32_t abstractLevels = 0;
+    for (size_t i = 1; i < learnt_.size(); ++i)
+        abstractLevels |= 1u << (level_[lvar(learnt_[i])] & 31);
+    size_t n = 1;
+    for (size_t i = 1; i < learnt_.size(); ++i)
+    {
+        if (reason_[lvar(learnt_[i])] == kNoReason || !redundant(learnt_[i], abstractLevels))
+            learnt_[n++] = learnt_[i];
+    }
+    learnt_.resize(n);
+
+    // backjump to the second highest level, its literal in position 1
+    btLevel = 0;
+    if (learnt_.size() > 1)
+    {
+        size_t maxI = 1;
+        for (size_t i = 2; i < learnt_.size(); ++i)
+        {
+            if (level_[lvar(learnt_[i])] > level_[lvar(learnt_[maxI])])
+                maxI = i;
+        }
+        swap(learnt_[1], learnt_[maxI]);
+        btLevel = level_[lvar(learnt_[1])];
+    }
+
+    for (int l : to_clear_)
+        seen_[lvar(l)] = 0;
+}
+
+// Is p implied by literals already in the learnt clause (seen)?
+bool Solver::redundant(int p, uint32_t abstractLevels)
+{
+    stack_.clear();
+    stack_.push_back(p);
+    size_t top = to_clear_.size();
+    while (!stack_.empty())
+    {
+        CRef r = reason_[lvar(stack_.back())];
+        stack_.pop_back();
+        int *c = clits(r);
+        uint32_t sz = csize(r);
+        for (uint32_t j = 1; j < sz; ++j)
+        {
+            int q = c[j];
+            int v = lvar(q);
+            if (seen_[v] || level_[v] == 0)
+                continue;
+            if (reason_[v] != kNoReason && (abstractLevels & (1u << (level_[v] & 31))))
+            {
+                seen_[v] = 1;
+                stack_.push_back(q);
+                to_clear_.push_back(q);
+            }
+            else
+            {
+                for (size_t k = top; k < to_clear_.size(); ++k)
+                    seen_[lvar(to_clear_[k])] = 0;
+                to_clear_.resize(top);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ---- VSIDS ----
+
+void Solver::heap_up(int i)
+{
+    int v = heap_[i];
+    while (i > 0)
+    {
+        int parent = (i - 1) >> 1;
+        if (!heap_less(v, heap_[parent]))
+            break;
+        heap_[i] = heap_[parent];
+        heap_index_[heap_[i]] = i;
+        i = parent;
+    }
+    heap_[i] = v;
+    heap_index_[v] = i;
+}
+
+void Solver::heap_down(int i)
+{
+    int v = heap_[i];
+    int n = (int)heap_.size();
+    while (2 * i + 1 < n)
+    {
+        int child = 2 * i + 1;
+        if (child + 1 < n && heap_less(heap_[child + 1], heap_[child]))
+            ++child;
+        if (!heap_less(heap_[child], v))
+            break;
+        heap_[i] = heap_[child];
+        heap_index_[heap_[i]] = i;
+        i = child;
+    }
+    heap_[i] = v;
+    heap_index_[v] = i;
+}
+
+void Solver::heap_insert(int v)
+{
+    heap_index_[v] = (int)heap_.size();
+    heap_.push_back(v);
+    heap_up(heap_index_[v]);
+}
+
+int Solver::heap_pop()
+{
+    int v = heap_[0];
+    heap_[0] = heap_.back();
+    heap_index_[heap_[0]] = 0;
+    heap_.pop_back();
+    heap_index_[v] = -1;
+    if (!heap_.empty())
+        heap_down(0);
+    return v;
+}
+
+void Solver::bump_var(int v)
+{
+    if ((activity_[v] += var_inc_) > 1e100)
+    {
+        for (double &a : activity_)
+            a *= 1e-100;
+        var_inc_ *= 1e-100;
+    }
+    if (heap_index_[v] >= 0)
+        heap_up(heap_index_[v]);
+}
+
+void Solver::bump_clause(CRef c)
+{
+    float a = cact(c) + (float)cla_inc_;
+    set_cact(c, a);
+    if (a > 1e20f)
+    {
+        for (CRef l : learnts_)
+            set_cact(l, cact(l) * 1e-20f);
+        cla_inc_ *= 1e-20;
+    }
+}
+
+int Solver::pick_branch()
+{
+    while (!heap_.empty())
+    {
+        int v = heap_pop();
+        if (assigns_[v] < 0 && decision_[v])
+            return 2 * v + polarity_[v];
+    }
+    return -1;
+}
+
+// ---- learnt clause database ----
+
+// Delete the less active half of the learnt clauses (binary and reason
+// clauses are kept), then compact the arena
+void Solver::reduce_db()
+{
+    sort(learnts_.begin(), learnts_.end(), [&](CRef a, CRef b)
+         { return csize(a) > 2 && (csize(b) == 2 || cact(a) < cact(b)); });
+
+    size_t n = 0;
+    for (size_t i = 0; i < learnts_.size(); ++i)
+    {
+        CRef c = learnts_[i];
+        int first = clits(c)[0];
+        bool locked = reason_[lvar(first)] == c && value(first) == 1;
+        if (i < learnts_.size() / 2 && csize(c) > 2 && !locked)
+            continue;
+        learnts_[n++] = c;
+    }
+    learnts_.resize(n);
+    collect_garbage();
+}
+
+// Copy the live clauses into a fresh arena, leaving each new position in the
+// old header's activity word to redirect reasons, and rebuild the watches
+void Solver::collect_garbage()
+{
+    vector<uint32_t> old;
+    old.swap(arena_);
+    arena_.reserve(old.size() / 2);
+    auto move = [&](CRef &c)
+    {
+        CRef to = (CRef)arena_.size();
+        uint32_t words = 2 + (old[c] & 0x7fffffffu);
+        arena_.insert(arena_.end(), old.begin() + c, old.begin() + c + words);
+        old[c + 1] = to;
+        c = to;
+    };
+
+    for (CRef &c : clauses_)
+        move(c);
+    for (CRef &c : learnts_)
+        move(c);
+    // reasons are never deleted (see reduce_db), so each has been moved
+    for (int l : trail_)
+    {
+        CRef &r = reason_[lvar(l)];
+        if (r != kNoReason)
+            r = old[r + 1];
+    }
+
+    for (auto &ws : watches_)
+        ws.clear();
+    for (CRef c : clauses_)
+        attach(c);
+    for (CRef c : learnts_)
+        attach(c);
+}
+
+// ---- search ----
+
+int Solver::search(int64_t conflictBudget, const vector<int> &assumptions)
+{
+    int64_t conflictC = 0;
+    for (;;)
+    {
+        CRef confl = propagate();
+        if (confl != kNoReason)
+        {
+            ++conflicts;
+            ++conflictC;
+            if (decision_level() == 0)
+            {
+                ok_ = false;
+                return 0;
+            }
+
+            int btLevel;
+            analyze(confl, btLevel);
+            cancel_until(btLevel);
+            if (learnt_.size() == 1)
+                enqueue(learnt_[0], kNoReason);
+            else
+            {
+                CRef c = alloc_clause(learnt_, true);
+                learnts_.push_back(c);
+                attach(c);
+                bump_clause(c);
+                enqueue(learnt_[0], c);
+            }
+            var_inc_ /= kVarDecay;
+            cla_inc_ /= kClauseDecay;
+
+            if (--learnt_adjust_cnt_ == 0)
+            {
+                learnt_adjust_confl_ *= 1.5;
+                learnt_adjust_cnt_ = (int64_t)learnt_adjust_confl_;
+                max_learnts_ *= 1.1;
+            }
+            continue;
+        }
+
+        if ((conflictBudget >= 0 && conflictC >= conflictBudget) || interrupted())
+        {
+            cancel_until(0);
+            return -1; // restart
+        }
+        if ((double)learnts_.size() - (double)trail_.size() >= max_learnts_)
+            reduce_db();
+
+        // assumptions take the first decision levels
+        int next = -1;
+        while (decision_level() < (int)assumptions.size())
+        {
+            int p = ilit(assumptions[decision_level()]);
+            if (value(p) == 1)
+                trail_lim_.push_back((int)trail_.size()); // already true: empty level
+            else if (value(p) == 0)
+                return 0; // UNSAT under the assumptions
+            else
+            {
+                next = p;
+                break;
+            }
+        }
+        if (next == -1)
+        {
+            ++decisions;
+            next = pick_branch();
+            if (next == -1)
+                return 1; // all assigned: model
+        }
+        trail_lim_.push_back((int)trail_.size());
+        enqueue(next, kNoReason);
+    }
+}
+
+bool Solver::solve(const vector<int> &assumptions)
+{
+    return solve_limited(assumptions, -1) == 1;
+}
+
+int Solver::solve_limited(const vector<int> &assumptions, int64_t maxConflicts)
+{
+    model_.clear();
+    if (!ok_)
+        return 0;
+    for (int a : assumptions)
+        reserve_vars(abs(a));
+    if (max_learnts_ == 0)
+        max_learnts_ = max(1000.0, clauses_.size() / 3.0);
+
+    uint64_t start = conflicts;
+    int result = -1;
+    for (int restarts = 0; result == -1 && !interrupted(); ++restarts)
+    {
+        int64_t budget = (int64_t)(luby(2, restarts) * kRestartBase);
+        if (maxConflicts >= 0)
+        {
+            int64_t left = maxConflicts - (int64_t)(conflicts - start);
+            if (left <= 0)
+                break;
+            budget = min(budget, left);
+        }
+        result = search(budget, assumptions);
+    }
+
+    if (result == 1)
+        model_.assign(assigns_.begin(), assigns_.end());
+    cancel_until(0);
+    return result;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include "CNF.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+// Embedded CDCL SAT solver: two watched literals, VSIDS with phase saving,
+// 1UIP learning with clause minimization, Luby restarts and activity-based
+// learnt clause deletion.
+//
+// Literals are DIMACS-style ints (v or -v, v >= 1), like CNF. The solver is
+// incremental: clauses can be added between solve() calls, and each call
+// may assume a set of literals, so several queries (one per output pair of
+// the miter) share one clause database and everything learnt so far.
+class Solver
+{
+public:
+    Solver() = default;
+
+    int num_vars() const { return (int)assigns_.size(); }
+    void reserve_vars(int n); // make variables 1..n exist
+
+    // Exclude var v from branching (it must then be implied by the others,
+    // like a gate output fixed by its inputs)
+    void set_decision_var(int v, bool d);
+
+    // false once the clause database is unsatisfiable without assumptions
+    bool add_clause(const vector<int> &lits) { return add_clause(lits.data(), lits.data() + lits.size()); }
+    bool add_clause(const int *begin, const int *end);
+    bool okay() const { return ok_; }
+
+    // Add clauses first.. of cnf (and its variables); returns cnf.num_clauses(),
+    // the 'first' to pass next time the same CNF has grown
+    size_t add_cnf(const CNF &cnf, size_t first = 0);
+
+    // true: SAT (model() holds a satisfying assignment that makes every
+    // assumption true); false: UNSAT under the assumptions
+    bool solve(const vector<int> &assumptions = {});
+
+    // Like solve(), but gives up after maxConflicts conflicts (< 0: no limit).
+    // 1: SAT, 0: UNSAT, -1: undecided
+    int solve_limited(const vector<int> &assumptions, int64_t maxConflicts);
+
+    // While *flag is true (set from another thread), solving stops and
+    // returns undecided
+    void set_interrupt(const atomic<bool> *flag) { interrupt_ = flag; }
+
+    // Value of var v (1-based) in the last model
+    bool model_value(int v) const { return v >= 1 && v <= (int)model_.size() && model_[v - 1] > 0; }
+
+    uint64_t conflicts = 0, decisions = 0, propagations = 0;
+
+private:
+    // internal literal: 2 * var + sign (var 0-based, sign 1 = negative)
+    static int ilit(int d) { return d > 0 ? 2 * (d - 1) : 2 * (-d - 1) + 1; }
+    static int lvar(int l) { return l >> 1; }
+    static int lneg(int l) { return l ^ 1; }
+
+    // Clause in the arena: [size | learnt << 31, activity (float bits), lits...]
+    typedef uint32_t CRef;
+    static constexpr CRef kNoReason = UINT32_MAX;
+    vector<uint32_t> arena_;
+    uint32_t csize(CRef c) const { return arena_[c] & 0x7fffffffu; }
+    bool clearnt(CRef c) const { return arena_[c] >> 31; }
+    float cact(CRef c) const
+    {
+        float a;
+        memcpy(&a, &arena_[c + 1], sizeof a);
+        return a;
+    }
+    void set_cact(CRef c, float a) { memcpy(&arena_[c + 1], &a, sizeof a); }
+    int *clits(CRef c) { return reinterpret_cast<int *>(&arena_[c + 2]); }
+    CRef alloc_clause(const vector<int> &lits, bool learnt);
+
+    struct Watcher
+    {
+        CRef cref;
+        int blocker;
+    };
+    vector<vector<Watcher>> watches_; // per internal literal: clauses watching its negation
+    vector<CRef> clauses_, learnts_;
+    double max_learnts_ = 0;           // learnt clause limit before reduce_db()
+    double learnt_adjust_confl_ = 100; // conflicts until the limit grows next,
+    int64_t learnt_adjust_cnt_ = 100;  // itself growing geometrically
+
+    // assignment: per var -1 unassigned, 0 false, 1 true (value of the positive literal)
+    vector<int8_t> assigns_;
+    vector<int> level_;
+    vector<CRef> reason_;
+    vector<int> trail_, trail_lim_;
+    size_t qhead_ = 0;
+    vector<int8_t> polarity_; // saved phase (1 = negative)
+    vector<int8_t> decision_; // may be branched on
+    vector<int8_t> model_;
+    bool ok_ = true;
+    const atomic<bool> *interrupt_ = nullptr;
+    bool interrupted() const { return interrupt_ && interrupt_->load(memory_order_relaxed); }
+
+    // VSIDS
+    vector<double> activity_;
+    double var_inc_ = 1.0;
+    double cla_inc_ = 1.0;
+    vector<int> heap_, heap_index_; // binary max-heap of vars by activity
+    bool heap_less(int a, int b) const { return activity_[a] > activity_[b]; }
+    void heap_up(int i);
+    void heap_down(int i);
+    void heap_insert(int v);
+    int heap_pop();
+
+    // analysis scratch
+    vector<int8_t> seen_;
+    vector<int> learnt_, stack_, to_clear_;
+
+    int value(int l) const
+    {
+        int8_t a = assigns_[lvar(l)];
+        return a < 0 ? -1 : (a ^ (l & 1));
+    }
+    int decision_level() const { return (int)trail_lim_.size(); }
+
+    void attach(CRef c);
+    void enqueue(int l, CRef from);
+    CRef propagate();
+    void analyze(CRef confl, int &btLevel);
+    bool redundant(int l, uint32_t abstractLevels);
+    void cancel_until(int level);
+    int pick_branch();
+    void bump_var(int v);
+    void bump_clause(CRef c);
+    void reduce_db();
+    void collect_garbage();
+    int search(int64_t conflictBudget, const vector<int> &assumptions); // 1 SAT, 0 UNSAT, -1 restart
+};
@@ -7,155 +7,303 @@
 using namespace std;
 
 // --- Gate encoders (Tseitin) ---
+// Each encoder defines z <-> gate(x) with two groups of clauses, and pol
+// selects which to emit (Plaisted-Greenbaum): POL_POS gives z -> gate(x),
+// enough where z is only ever required to be true; POL_NEG gives
+// gate(x) -> z, enough where z is only ever required to be false.
+constexpr char POL_NONE = 0, POL_POS = 1, POL_NEG = 2, POL_BOTH = POL_POS | POL_NEG;
+inline char flip(char pol) { return (char)(((pol & POL_POS) << 1) | ((pol & POL_NEG) >> 1)); }
+
 // z = NOT x
-inline void enc_NOT(CNF &cnf, int z, int x)
+inline void enc_NOT(CNF &cnf, int z, int x, char pol = POL_BOTH)
 {
-    cnf.add_clause({-z, -x});
-    cnf.add_clause({z, x});
+    if (pol & POL_POS)
+        cnf.add_clause({-z, -x});
+    if (pol & POL_NEG)
+        cnf.add_clause({z, x});
 }
 // z = BUFF x
-inline void enc_BUFF(CNF &cnf, int z, int x)
+inline void enc_BUFF(CNF &cnf, int z, int x, char pol = POL_BOTH)
 {
-    cnf.add_clause({-z, x});
-    cnf.add_clause({z, -x});
+    if (pol & POL_POS)
+        cnf.add_clause({-z, x});
+    if (pol & POL_NEG)
+        cnf.add_clause({z, -x});
 }
 // z = AND(x1..xn)
-inline void enc_AND(CNF &cnf, int z, const vector<int> &xs)
+inline void enc_AND(CNF &cnf, int z, const vector<int> &xs, char pol = POL_BOTH)
 {
     // z -> xi  === (¬z ∨ xi) for all i
-    for (int x : xs)
-        cnf.add_clause({-z, x});
+    if (pol & POL_POS)
+        for (int x : xs)
+            cnf.add_clause({-z, x});
 
     // (x1 ∧ ... ∧ xn) -> z  === (¬x1 ∨ ¬x2 ∨ ... ∨ z)
-    vector<int> big;
-    big.reserve(xs.size() + 1);
-    for (int x : xs)
-        big.push_back(-x);
-    big.push_back(z);
-    cnf.add_clause(big);
+    if (pol & POL_NEG)
+    {
+        vector<int> big;
+        big.reserve(xs.size() + 1);
+        for (int x : xs)
+            big.push_back(-x);
+        big.push_back(z);
+        cnf.add_clause(big);
+    }
 }
 
 // z = OR(x1..xn)
-inline void enc_OR(CNF &cnf, int z, const vector<int> &xs)
+inline void enc_OR(CNF &cnf, int z, const vector<int> &xs, char pol = POL_BOTH)
 {
-    for (int x : xs)
-        cnf.add_clause({-x, z});
-    vector<int> big = xs;
-    big.push_back(-z);
-    cnf.add_clause(big);
+    if (pol & POL_NEG)
+        for (int x : xs)
+            cnf.add_clause({-x, z});
+    if (pol & POL_POS)
+    {
+        vector<int> big = xs;
+        big.push_back(-z);
+        cnf.add_clause(big);
+    }
 }
 // z = XOR(a,b)
-inline void enc_XOR2(CNF &cnf, int z, int a, int b)
+inline void enc_XOR2(CNF &cnf, int z, int a, int b, char pol = POL_BOTH)
+{
+    if (pol & POL_POS)
+    {
+        cnf.add_clause({-a, -b, -z});
+        cnf.add_clause({a, b, -z});
+    }
+    if (pol & POL_NEG)
+    {
+        cnf.add_clause({a, -b, z});
+        cnf.add_clause({-a, b, z});
+    }
+}
+// z = XOR(x1..xn): one clause per input assignment of the wrong parity,
+// 2^(n-1) per direction, so only for small n
+inline void enc_XORN(CNF &cnf, int z, const vector<int> &xs, char pol = POL_BOTH)
+{
+    const size_t n = xs.size();
+    vector<int> cl(n + 1);
+    for (uint32_t m = 0; m < (1u << n); ++m)
+    {
+        // the clause excludes x = m (bit i: xi true) together with the z
+        // value of the other parity
+        bool odd = __builtin_popcount(m) & 1;
+        if (!(pol & (odd ? POL_NEG : POL_POS)))
+            continue;
+        for (size_t i = 0; i < n; ++i)
+            cl[i] = (m >> i) & 1 ? -xs[i] : xs[i];
+        cl[n] = odd ? z : -z;
+        cnf.add_clause(cl);
+    }
+}
+// z = XOR(x1..xn) for any n >= 2: one enc_XORN over up to kXorWidth inputs,
+// the last of them standing for the XOR of the rest
+constexpr size_t kXorWidth = 3; // 2^3 clauses, as many as two chained XOR2s
+inline void enc_XOR(CNF &cnf, int z, const vector<int> &xs, char pol = POL_BOTH)
 {
-    cnf.add_clause({-a, -b, -z});
-    cnf.add_clause({a, b, -z});
-    cnf.add_clause({a, -b, z});
-    cnf.add_clause({-a, b, z});
+    if (xs.size() == 2)
+    {
+        enc_XOR2(cnf, z, xs[0], xs[1], pol);
+        return;
+    }
+    if (xs.size() <= kXorWidth)
+    {
+        enc_XORN(cnf, z, xs, pol);
+        return;
+    }
+    vector<int> head(xs.begin(), xs.begin() + kXorWidth - 1), rest(xs.begin() + kXorWidth - 1, xs.end());
+    int t = cnf.new_var();
+    enc_XOR(cnf, t, rest); // below an XOR: needed both ways
+    head.push_back(t);
+    enc_XORN(cnf, z, head, pol);
 }
 
-inline void enc_NAND(CNF &cnf, int z, const vector<int> &xs)
+inline void enc_NAND(CNF &cnf, int z, const vector<int> &xs, char pol = POL_BOTH)
 {
     if (xs.empty())
         throw runtime_error("NAND of 0 inputs is undefined");
     if (xs.size() == 1)
     {
-        enc_NOT(cnf, z, xs[0]);
+        enc_NOT(cnf, z, xs[0], pol);
         return;
     } // NAND(x) = NOT(x)
 
     // (xi ∨ z)  for each input
-    for (int x : xs)
-        cnf.add_clause({x, z});
+    if (pol & POL_NEG)
+        for (int x : xs)
+            cnf.add_clause({x, z});
 
     // (¬x1 ∨ ¬x2 ∨ ... ∨ ¬xn ∨ ¬z)
-    vector<int> big;
-    big.reserve(xs.size() + 1);
-    for (int x : xs)
-        big.push_back(-x);
-    big.push_back(-z);
-    cnf.add_clause(big);
+    if (pol & POL_POS)
+    {
+        vector<int> big;
+        big.reserve(xs.size() + 1);
+        for (int x : xs)
+            big.push_back(-x);
+        big.push_back(-z);
+        cnf.add_clause(big);
+    }
 }
 
-inline void enc_NOR(CNF &cnf, int z, const vector<int> &xs)
+inline void enc_NOR(CNF &cnf, int z, const vector<int> &xs, char pol = POL_BOTH)
 {
     if (xs.empty())
         throw runtime_error("NOR of 0 inputs is undefined");
     if (xs.size() == 1)
     {
-        enc_NOT(cnf, z, xs[0]);
+        enc_NOT(cnf, z, xs[0], pol);
         return;
     } // NOR(x) = NOT(x)
 
     // (¬xi ∨ ¬z)  for each input
-    for (int x : xs)
-        cnf.add_clause({-x, -z});
+    if (pol & POL_POS)
+        for (int x : xs)
+            cnf.add_clause({-x, -z});
 
     // (x1 ∨ x2 ∨ ... ∨ xn ∨ z)
-    vector<int> big(xs.begin(), xs.end());
-    big.push_back(z);
-    cnf.add_clause(big);
+    if (pol & POL_NEG)
+    {
+        vector<int> big(xs.begin(), xs.end());
+        big.push_back(z);
+        cnf.add_clause(big);
+    }
+}
+
+// z = gate(xs) for any gate type
+inline void enc_gate(CNF &cnf, GateType type, int z, const vector<int> &xs, char pol = POL_BOTH)
+{
+    switch (type)
+    {
+    case GateType::NOT:
+        enc_NOT(cnf, z, xs[0], pol);
+        break;
+    case GateType::BUFF:
+        enc_BUFF(cnf, z, xs[0], pol);
+        break;
+    case GateType::AND:
+        enc_AND(cnf, z, xs, pol);
+        break;
+    case GateType::OR:
+        enc_OR(cnf, z, xs, pol);
+        break;
+    case GateType::XOR:
+        enc_XOR(cnf, z, xs, pol);
+        break;
+    case GateType::NAND:
+        enc_NAND(cnf, z, xs, pol);
+        break;
+    case GateType::NOR:
+        enc_NOR(cnf, z, xs, pol);
+        break;
+    }
+}
+
+// Polarity a gate of the given type and output polarity needs of its inputs
+inline char input_polarity(GateType type, char pol)
+{
+    switch (type)
+    {
+    case GateType::NOT:
+    case GateType::NAND:
+    case GateType::NOR:
+        return flip(pol);
+    case GateType::XOR:
+        return pol ? POL_BOTH : POL_NONE;
+    default:
+        return pol;
+    }
 }
 
 // Encode one parsed circuit. Returns PO vars in the same order as ckt.outputs.
-inline vector<int> encode_circuit_to_cnf(CNF &cnf, PinTable &pt, const Circuit &ckt, const string &prefix)
+// Vars are created on first use, outputs first, then gate by gate in file
+// order; PIs are shared with earlier circuits through pt.pi_to_var.
+// With pol, gate g is encoded with polarity pol[g], and not at all when 0.
+inline vector<int> encode_circuit_to_cnf(CNF &cnf, PinTable &pt, const Circuit &ckt, const string &prefix,
+                                         const vector<char> *pol = nullptr, const vector<int> *roots = nullptr)
 {
-    unordered_set<string> pi(ckt.inputs.begin(), ckt.inputs.end());
-    auto pin2var = [&](const string &s) -> int
+    vector<char> pi(ckt.num_nets(), 0);
+    for (int x : ckt.inputs)
+        pi[x] = 1;
+
+    pt.scopes.push_back(PinTable::Scope{prefix, &ckt.names, vector<int>(ckt.num_nets(), 0)});
+    vector<int> &net_to_var = pt.scopes.back().net_to_var;
+    auto net2var = [&](int n) -> int
     {
-        if (pi.count(s))
-            return pt.get_or_create_pi(cnf, s);
-        return pt.get_or_create_net(cnf, prefix + "/" + s);
+        if (!net_to_var[n])
+            net_to_var[n] = pi[n] ? pt.get_or_create_pi(cnf, ckt.names[n]) : cnf.new_var();
+        return net_to_var[n];
     };
 
+    const vector<int> &outNets = roots ? *roots : ckt.outputs;
     vector<int> outs;
-    outs.reserve(ckt.outputs.size());
-    for (const auto &o : ckt.outputs)
-        outs.push_back(pt.get_or_create_net(cnf, prefix + "/" + o));
-
-    for (const auto &g : ckt.gates)
-    {
-        int z = pt.get_or_create_net(cnf, prefix + "/" + g.out);
-        vector<int> xs;
-        xs.reserve(g.ins.size());
-        for (auto &s : g.ins)
-            xs.push_back(pin2var(s));
-        if (g.type == "NOT")
-            enc_NOT(cnf, z, xs[0]);
-        else if (g.type == "BUFF")
-            enc_BUFF(cnf, z, xs[0]);
-        else if (g.type == "AND")
-            enc_AND(cnf, z, xs);
-        else if (g.type == "OR")
-            enc_OR(cnf, z, xs);
-        else if (g.type == "XOR")
-            enc_XOR2(cnf, z, xs[0], xs[1]);
-        else if (g.type == "NAND")
-            enc_NAND(cnf, z, xs);
-        else if (g.type == "NOR")
-            enc_NOR(cnf, z, xs);
-        else
-            throw runtime_error("Unsupported gate in encoder: " + g.type);
+    outs.reserve(outNets.size());
+    for (int o : outNets)
+        outs.push_back(net2var(o));
+
+    vector<int> xs;
+    for (size_t gi = 0; gi < ckt.gates.size(); ++gi)
+    {
+        char gp = pol ? (*pol)[gi] : POL_BOTH;
+        if (!gp)
+            continue;
+        const Gate &g = ckt.gates[gi];
+        int z = net2var(g.out);
+        xs.clear();
+        for (const int *p = ckt.ins_begin(g); p != ckt.ins_end(g); ++p)
+            xs.push_back(net2var(*p));
+        enc_gate(cnf, g.type, z, xs, gp);
     }
     return outs;
 }
 
+// Per gate, the polarity its output is needed in when the given nets are
+// needed in rootPol; POL_NONE outside their transitive fan-in. With
+// rootPol = POL_BOTH every gate in the cone gets POL_BOTH.
+inline vector<char> gate_polarity(const Circuit &ckt, const vector<int> &roots, char rootPol = POL_BOTH)
+{
+    vector<char> netPol(ckt.num_nets(), POL_NONE);
+    for (int r : roots)
+        netPol[r] = rootPol;
+    vector<char> pol(ckt.gates.size(), POL_NONE);
+    for (size_t k = ckt.topo.size(); k-- > 0;)
+    {
+        int gi = ckt.topo[k];
+        const Gate &g = ckt.gates[gi];
+        char p = pol[gi] = netPol[g.out];
+        if (!p)
+            continue;
+        char ip = input_polarity(g.type, p);
+        for (const int *q = ckt.ins_begin(g); q != ckt.ins_end(g); ++q)
+            netPol[*q] |= ip;
+    }
+    return pol;
+}
+
+// Encode only the cone of the given nets; returns their vars
+inline vector<int> encode_cone_to_cnf(CNF &cnf, PinTable &pt, const Circuit &ckt, const string &prefix,
+                                      const vector<int> &roots)
+{
+    vector<char> pol = gate_polarity(ckt, roots);
+    return encode_circuit_to_cnf(cnf, pt, ckt, prefix, &pol, &roots);
+}
+
 // --- Miter helpers ---
 // for XORing the same outputs of two circuits
-inline int mk_xor(CNF &cnf, int a, int b)
+inline int mk_xor(CNF &cnf, int a, int b, char pol = POL_BOTH)
 {
     int z = cnf.new_var();
-    enc_XOR2(cnf, z, a, b);
+    enc_XOR2(cnf, z, a, b, pol);
     return z;
 }
 
 // for ORing the XORed outputs of the Miter circuit
-inline int mk_or_many(CNF &cnf, const vector<int> &xs)
+inline int mk_or_many(CNF &cnf, const vector<int> &xs, char pol = POL_BOTH)
 {
     if (xs.empty())
         throw runtime_error("mk_or_many: empty");
     if (xs.size() == 1)
         return xs[0];
     int z = cnf.new_var();
-    enc_OR(cnf, z, xs);
+    enc_OR(cnf, z, xs, pol);
     return z;
 }
@@ -1,24 +1,159 @@
 #include "BenchParser.hpp"
 #include "CNF.hpp"
 #include "Tseitin.hpp"
+#include "AIG.hpp"
+#include "Solver.hpp"
+#include "Sim.hpp"
+#include "Fraig.hpp"
+#include "MiterPool.hpp"
+#include "Preprocess.hpp"
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <unordered_map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
 using namespace std;
 
-static bool outputs_align_by_index = true; // flip to false to align by name
+static bool outputs_align_by_index = true;     // flip to false to align by name
+static const int sim_max_passes = 16;          // random simulation: up to 16 * 256 patterns,
+static const size_t sim_gate_budget = 1 << 23; // fewer on large designs (gate evaluations)
 
+// Print a counterexample: the differing output and a value for every input
+// of A (value(net) gives it for an input net of A)
+template <class Value>
+static void print_counterexample(const Circuit &A, int output, Value value)
+{
+    cout << "NOT EQUIVALENT\n";
+    cout << "Output " << A.names[A.outputs[output]] << " differs\n";
+    cout << "Counterexample:\n";
+    for (int x : A.inputs)
+        cout << "  " << A.names[x] << " = " << value(x) << "\n";
+}
+
+static bool ends_with(const string &s, const string &suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static string shell_quote(const string &s)
+{
+    string q = "'";
+    for (char c : s)
+        q += c == '\'' ? string("'\\''") : string(1, c);
+    return q + "'";
+}
+
+// Stream the CNF into cmd's stdin, without a file on disk; returns the
+// command's exit status, -1 if it could not be started
+static int pipe_dimacs(const CNF &cnf, const string &cmd)
+{
+    cout.flush();
+    FILE *f = popen(cmd.c_str(), "w");
+    if (!f)
+        return -1;
+    cnf.write_dimacs(f);
+    int st = pclose(f);
+    return st == -1 ? -1 : WEXITSTATUS(st);
+}
+
+// Run the preprocessor over cnf and report what it did; false: UNSAT
+static bool simplify(Preprocessor &pre, CNF &cnf)
+{
+    bool ok = pre.run(cnf);
+    const Preprocessor::Stats &s = pre.stats;
+    cout << "Preprocess: " << s.clausesBefore << " -> " << s.clausesAfter << " clauses; " << s.units
+         << " units, " << s.eliminated << " vars eliminated, " << s.subsumed << " subsumed, " << s.strengthened
+         << " strengthened" << (ok ? "" : "; UNSAT") << "\n";
+    return ok;
+}
+
+// Report the output pairs proven equal: all but those in outIdx (which were
+// left to SAT), plus outIdx[j] for every proven[j]
+static void print_proven(const Circuit &A, const vector<int> &outIdx, const vector<char> &proven)
+{
+    vector<char> equal(A.outputs.size(), 1);
+    for (size_t j = 0; j < outIdx.size(); ++j)
+        equal[outIdx[j]] = proven[j];
+    size_t k = 0;
+    for (char e : equal)
+        k += e;
+    cout << "Proven equal: " << k << "/" << A.outputs.size() << " output pairs";
+    if (k != A.outputs.size())
+    {
+        cout << ":";
+        for (size_t i = 0; i < equal.size(); ++i)
+            if (equal[i])
+                cout << " " << A.names[A.outputs[i]];
+    }
+    cout << "\n";
+}
+
+// Options (anywhere on the command line):
+//   --no-aig   encode both circuits gate by gate instead of through the shared AIG
+//   --solve    decide equivalence with the built-in solver; out.dimacs is optional
+//   --no-sim   skip the random simulation pre-pass
+//   --no-fraig do not sweep the AIG (merge SAT-proven equivalent nodes)
+//   --pipe=CMD stream the DIMACS into CMD's stdin (e.g. a SAT solver); out.dimacs
+//              is then optional. An out.dimacs ending in .gz is written through gzip
+//   --jobs=N   with --solve and N > 1, solve one miter per output pair (over
+//              their cones only) on N threads; default: hardware threads
+//   --simp     preprocess the CNF (unit propagation, subsumption, variable
+//              elimination) before it is written or solved
+//   --pg       polarity-aware (Plaisted-Greenbaum) encoding: AND/XOR trees of the
+//              AIG as wide gates, each only in the direction the miter needs
 int main(int argc, char **argv)
 {
-    if (argc != 4)
+    bool useAig = true;
+    bool solve = false;
+    bool useSim = true;
+    bool useFraig = true;
+    bool pg = false;
+    bool simp = false;
+    int jobs = max(1u, thread::hardware_concurrency());
+    string pipeCmd;
+    vector<string> args;
+    for (int i = 1; i < argc; ++i)
+    {
+        string a = argv[i];
+        if (a == "--no-aig")
+            useAig = false;
+        else if (a == "--solve")
+            solve = true;
+        else if (a == "--no-sim")
+            useSim = false;
+        else if (a == "--no-fraig")
+            useFraig = false;
+        else if (a == "--pg")
+            pg = true;
+        else if (a == "--simp")
+            simp = true;
+        else if (a.compare(0, 7, "--pipe=") == 0 && a.size() > 7)
+            pipeCmd = a.substr(7);
+        else if (a.compare(0, 7, "--jobs=") == 0 && atoi(a.c_str() + 7) > 0)
+            jobs = atoi(a.c_str() + 7);
+        else if (a.compare(0, 2, "--") == 0)
+        {
+            cerr << "Unknown option: " << a << "\n";
+            return 1;
+        }
+        else
+            args.push_back(a);
+    }
+    if (args.size() != 3 && !((solve || !pipeCmd.empty()) && args.size() == 2))
     {
-        cerr << "Usage: ./ec <A.bench> <B.bench> <out.dimacs>\n";
+        cerr << "Usage: ./ec <A.bench> <B.bench> <out.dimacs[.gz]> [--pipe=CMD] [--pg] [--simp] [--no-aig] [--no-sim] [--no-fraig]\n"
+             << "       ./ec <A.bench> <B.bench> [out.dimacs[.gz]] --pipe=CMD [--pg] [--simp] [--no-aig] [--no-sim] [--no-fraig]\n"
+             << "       ./ec <A.bench> <B.bench> [out.dimacs[.gz]] --solve [--jobs=N] [--pg] [--simp] [--no-aig] [--no-sim] [--no-fraig]\n";
         return 1;
     }
+    const bool writeCnf = args.size() == 3 || !pipeCmd.empty();
     try
     {
-        Circuit A = parse_bench(argv[1]);
-        Circuit B = parse_bench(argv[2]);
+        Circuit A = parse_bench(args[0]);
+        Circuit B = parse_bench(args[1]);
 
         // cout << "circuit A:\n";
         // print_circuit(A);
@@ -33,77 +168,273 @@ int main(int argc, char **argv)
             return 2;
         }
 
-        CNF cnf;
-        PinTable pt;
+        // Pair the outputs by NAME: A.outputs[i] with B.outputs[pairB[i]]
+        unordered_map<string_view, int> Bmap;
+        for (size_t i = 0; i < B.outputs.size(); ++i)
+            Bmap[B.names[B.outputs[i]]] = (int)i;
+        vector<int> pairB;
+        pairB.reserve(A.outputs.size());
+        for (int o : A.outputs)
+        {
+            auto it = Bmap.find(A.names[o]);
+            if (it == Bmap.end())
+            {
+                cerr << "PO missing in B: " << A.names[o] << "\n";
+                exit(2);
+            }
+            pairB.push_back(it->second);
+        }
 
-        // Encode both circuits; PIs are shared via PinTable
-        vector<int> Aout = encode_circuit_to_cnf(cnf, pt, A, "A");
-        vector<int> Bout = encode_circuit_to_cnf(cnf, pt, B, "B");
+        // Random simulation first: most non-equivalent pairs differ on some
+        // random pattern, which settles it without any SAT
+        bool decided = false;
+        if (useSim)
+        {
+            size_t gates = max<size_t>(1, A.gates.size() + B.gates.size());
+            int passes = (int)min<size_t>(sim_max_passes, max<size_t>(1, sim_gate_budget / gates));
+            PairSim sim(A, B, pairB);
+            if (sim.run(passes))
+            {
+                cout << "Simulation: difference found after " << sim.patterns() << " patterns\n";
+                print_counterexample(A, sim.failing_output(), [&](int x)
+                                     { return sim.value_A(x); });
+                decided = true;
+                if (!writeCnf)
+                    return 0;
+            }
+            else
+                cout << "Simulation: " << sim.patterns() << " patterns, no difference\n";
+        }
 
-        print_PinTable(pt);
+        AIG aig;                // both circuits, structurally hashed; PIs shared by name
+        vector<int> Alit, Blit; // their PO literals in aig
+        vector<int> outIdx;     // index into A.outputs of each output pair still to compare
 
-        // Optional: align by name
-        if (!outputs_align_by_index)
+        if (useAig)
         {
-            unordered_map<string, int> mapB;
-            for (size_t i = 0; i < B.outputs.size(); ++i)
-                mapB[B.outputs[i]] = Bout[i];
-            vector<int> Bout2;
-            Bout2.reserve(A.outputs.size());
-            for (auto &name : A.outputs)
+            Alit = aig.add_circuit(A);
+            Blit = aig.add_circuit(B);
+            auto count_equal = [&]
             {
-                if (!mapB.count(name))
+                size_t k = 0;
+                for (size_t i = 0; i < Alit.size(); ++i)
+                    k += Alit[i] == Blit[pairB[i]]; // same node: equal for every input
+                return k;
+            };
+            size_t proven = count_equal();
+            cout << "AIG: " << aig.num_ands() << " ANDs, " << proven << "/" << Alit.size()
+                 << " output pairs structurally equal\n";
+
+            if (useFraig && proven < Alit.size())
+            {
+                // Merge internal nodes proven equal, so the pairs left over
+                // mostly become the same node too
+                vector<int> lits = Alit;
+                lits.insert(lits.end(), Blit.begin(), Blit.end());
+                Fraig fraig(aig);
+                AIG swept = fraig.run(lits);
+                Alit.assign(lits.begin(), lits.begin() + Alit.size());
+                Blit.assign(lits.begin() + Alit.size(), lits.end());
+                aig = std::move(swept);
+
+                proven = count_equal();
+                cout << "Fraig: " << fraig.stats.proved << " merges proved, " << fraig.stats.disproved
+                     << " refuted, " << fraig.stats.undecided << " undecided; " << proven << "/" << Alit.size()
+                     << " output pairs equal" << (fraig.stats.limited ? " (effort limit reached)" : "") << "\n";
+            }
+
+            for (size_t i = 0; i < Alit.size(); ++i)
+                if (Alit[i] != Blit[pairB[i]])
+                    outIdx.push_back((int)i);
+        }
+        else
+        {
+            for (size_t i = 0; i < A.outputs.size(); ++i)
+                outIdx.push_back((int)i);
+        }
+
+        // With pg, a miter only ever needs its XORs and OR to be true
+        const char diffPol = pg ? POL_POS : POL_BOTH;
+
+        if (solve && !decided && jobs > 1)
+        {
+            // One small miter per remaining output pair, over its cones only
+            MiterPoolResult r = solve_miters(outIdx.size(), jobs, [&](size_t j, CNF &c, PinTable &p)
+                                             {
+                int i = outIdx[j];
+                if (useAig)
                 {
-                    cerr << "Missing PO: " << name << "\n";
-                    return 3;
+                    vector<int> l = encode_aig_to_cnf(c, p, aig, {Alit[i], Blit[pairB[i]]}, pg);
+                    return mk_xor(c, l[0], l[1], diffPol);
                 }
-                Bout2.push_back(mapB[name]);
+                int a = encode_cone_to_cnf(c, p, A, "A", {A.outputs[i]})[0];
+                int b = encode_cone_to_cnf(c, p, B, "B", {B.outputs[pairB[i]]})[0];
+                return mk_xor(c, a, b, diffPol); }, simp);
+            cout << "Solver: " << outIdx.size() << " output cones on " << jobs << " threads, "
+                 << r.conflicts << " conflicts\n";
+
+            print_proven(A, outIdx, r.proven);
+            if (r.failing < 0)
+                cout << "EQUIVALENT\n";
+            else
+            {
+                // inputs outside the failing cones are don't-cares: 0
+                print_counterexample(A, outIdx[r.failing], [&](int x)
+                                     {
+                    auto it = r.cex.find(A.names[x]);
+                    return it != r.cex.end() && it->second; });
             }
-            Bout.swap(Bout2);
+            decided = true;
+            if (!writeCnf)
+                return 0;
         }
 
-        // XOR each matching output (by NAME recommended)
+        CNF cnf;
+        PinTable pt;
+        vector<int> Aout, Bout; // CNF literals of the output pairs in outIdx
+
+        if (useAig)
+        {
+            vector<int> roots;
+            for (int i : outIdx)
+            {
+                roots.push_back(Alit[i]);
+                roots.push_back(Blit[pairB[i]]);
+            }
+            vector<int> lits = encode_aig_to_cnf(cnf, pt, aig, roots, pg);
+            for (size_t k = 0; k < lits.size(); k += 2)
+            {
+                Aout.push_back(lits[k]);
+                Bout.push_back(lits[k + 1]);
+            }
+        }
+        else
+        {
+            // Encode both circuits; PIs are shared via PinTable. With pg,
+            // gates no output depends on are left out.
+            vector<char> polA, polB;
+            if (pg)
+            {
+                polA = gate_polarity(A, A.outputs);
+                polB = gate_polarity(B, B.outputs);
+            }
+            Aout = encode_circuit_to_cnf(cnf, pt, A, "A", pg ? &polA : nullptr);
+            vector<int> allB = encode_circuit_to_cnf(cnf, pt, B, "B", pg ? &polB : nullptr);
+            for (int j : pairB)
+                Bout.push_back(allB[j]);
+        }
+
+        print_PinTable(pt);
+
+        // XOR each matching output
         vector<int> diffs;
         diffs.reserve(Aout.size());
+        for (size_t i = 0; i < Aout.size(); ++i)
+            diffs.push_back(mk_xor(cnf, Aout[i], Bout[i], diffPol));
 
-        unordered_map<string, int> Bmap;
-        for (size_t i = 0; i < B.outputs.size(); ++i)
-            Bmap[B.outputs[i]] = Bout[i];
-
-        for (size_t i = 0; i < A.outputs.size(); ++i)
+        if (solve && !decided)
         {
-            const string &name = A.outputs[i];
-            auto it = Bmap.find(name);
-            if (it == Bmap.end())
+            // One query per output pair, assuming its XOR true, all against
+            // the same clause database so later pairs reuse what was learnt.
+            // The preprocessor must keep the assumed XORs, and the PIs too
+            // when the CNF is still to be written.
+            Preprocessor pre;
+            Solver solver;
+            if (simp)
             {
-                cerr << "PO missing in B: " << name << "\n";
-                exit(2);
+                for (int d : diffs)
+                    pre.freeze(abs(d));
+                if (writeCnf)
+                    for (const auto &p : pt.pi_to_var)
+                        pre.freeze(p.second);
+                simplify(pre, cnf);
+            }
+            solver.add_cnf(cnf);
+            int failing = -1;
+            vector<char> proven(diffs.size(), 0);
+            for (size_t i = 0; i < diffs.size() && failing < 0; ++i)
+            {
+                if (solver.solve({diffs[i]}))
+                    failing = (int)i;
+                else
+                    proven[i] = 1;
+            }
+            cout << "Solver: " << solver.conflicts << " conflicts, " << solver.decisions << " decisions\n";
+
+            print_proven(A, outIdx, proven);
+            if (failing < 0)
+                cout << "EQUIVALENT\n";
+            else
+            {
+                // inputs outside every compared cone are don't-cares: 0
+                vector<char> model(cnf.var_cnt + 1);
+                for (int v = 1; v <= cnf.var_cnt; ++v)
+                    model[v] = solver.model_value(v);
+                pre.extend_model(model);
+                print_counterexample(A, outIdx[failing], [&](int x)
+                                     {
+                    auto it = pt.pi_to_var.find(A.names[x]);
+                    return it != pt.pi_to_var.end() && model[it->second]; });
             }
-            diffs.push_back(mk_xor(cnf, Aout[i], it->second));
+            if (!writeCnf)
+                return 0;
         }
 
-        // Build OR node: diff ↔ (d1 ∨ d2 ∨ ... ∨ dk)
-        int diff = mk_or_many(cnf, diffs);
+        if (diffs.empty())
+        {
+            // nothing left to compare: a trivially UNSAT instance (equivalent)
+            int v = cnf.new_var();
+            cnf.add_clause({v});
+            cnf.add_clause({-v});
+        }
+        else
+        {
+            // Build OR node: diff ↔ (d1 ∨ d2 ∨ ... ∨ dk)
+            int diff = mk_or_many(cnf, diffs, diffPol);
 
-        // Force the OR to be true (i.e., at least one differs)
-        cnf.add_clause({diff});
+            // Force the OR to be true (i.e., at least one differs)
+            cnf.add_clause({diff});
 
-        // Build miter: di = XOR(Aout[i], Bout[i]); diff = OR(di...); assert diff
-        // vector<int> diffs;
-        // diffs.reserve(Aout.size());
-        // for (size_t i = 0; i < Aout.size(); ++i)
-        //     diffs.push_back(mk_xor(cnf, Aout[i], Bout[i]));
-        // int diff = mk_or_many(cnf, diffs);
-        // cnf.add_clause({diff}); // force difference = true
+            if (simp)
+            {
+                // the PIs stay, so a model still reads through the pin table
+                Preprocessor pre;
+                for (const auto &p : pt.pi_to_var)
+                    pre.freeze(p.second);
+                simplify(pre, cnf);
+            }
+        }
 
-        ofstream ofs(argv[3]);
-        if (!ofs)
+        if (args.size() == 3 && !ends_with(args[2], ".gz"))
+        {
+            ofstream ofs(args[2]);
+            if (!ofs)
+            {
+                cerr << "Cannot open output file.\n";
+                return 4;
+            }
+            cnf.write_dimacs(ofs);
+            cout << "Wrote DIMACS to " << args[2] << "\n";
+        }
+        else if (args.size() == 3)
         {
-            cerr << "Cannot open output file.\n";
-            return 4;
+            if (pipe_dimacs(cnf, "gzip -1 -c > " + shell_quote(args[2])) != 0)
+            {
+                cerr << "Cannot write output file.\n";
+                return 4;
+            }
+            cout << "Wrote DIMACS to " << args[2] << "\n";
+        }
+        if (!pipeCmd.empty())
+        {
+            // the command's own output (e.g. the solver's verdict) follows
+            cout << "Streaming DIMACS to: " << pipeCmd << "\n";
+            if (pipe_dimacs(cnf, pipeCmd) < 0)
+            {
+                cerr << "Cannot run: " << pipeCmd << "\n";
+                return 4;
+            }
         }
-        cnf.write_dimacs(ofs);
-        cout << "Wrote DIMACS to " << argv[3] << "\n";
         // cout << "UNSAT => equivalent; SAT => not equivalent.\n";
         cout << "DONE\n";
     }